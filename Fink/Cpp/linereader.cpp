@@ -0,0 +1,153 @@
+/****************************************************************************
+FILE          : linereader.cpp
+LAST REVISED  : 2026-10-19
+SUBJECT       : Implementation of a class that reads the lines of a file.
+PROGRAMMER    : (C) Copyright 2026 by Peter Chapin
+
+On POSIX systems the file is memory mapped so reading it requires no
+copying at all. On other systems the file is read into a single buffer.
+In both cases each line is returned as a pointer into the file's contents
+together with a length.
+
+
+LICENSE
+
+This program is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2 of the License, or (at your
+option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANT-
+ABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+Please send comments or bug reports pertaining to this file to
+
+     Peter Chapin
+     Vermont Technical College
+     Randolph Center, VT 05061
+     pchapin@ecet.vtc.edu
+****************************************************************************/
+
+#include "environ.hpp"
+#include <cstring>
+#include "linereader.hpp"
+
+#if eOPSYS == ePOSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+/*! \class pcc::LineReader
+
+  <p>A LineReader holds the entire contents of a file. Each call to
+  next() returns a pointer to the start of the following line and the
+  number of characters in that line. The line is <em>not</em> null
+  terminated and the pointer is only valid while the LineReader exists.
+  The newline character is not included in the line. A final line that
+  does not end with a newline is still returned.</p>
+
+  <p>If the file can't be opened the LineReader behaves as if the file
+  was empty and is_open() returns false. The only exception that might
+  be thrown is std::bad_alloc on systems where the file must be read into
+  a buffer.</p>
+*/
+
+namespace pcc {
+
+  LineReader::LineReader(const char *file_name)
+    : data(0), size(0), position(0), mapped(false), open(false), line_count(0)
+  {
+    #if eOPSYS == ePOSIX
+    int handle = ::open(file_name, O_RDONLY);
+    if (handle == -1) return;
+
+    struct stat info;
+    if (fstat(handle, &info) == 0) {
+      size = static_cast<std::size_t>(info.st_size);
+      open = true;
+
+      // Empty files can't be mapped, but there is nothing to read anyway.
+      if (size != 0) {
+        void *p = mmap(0, size, PROT_READ, MAP_PRIVATE, handle, 0);
+        if (p == MAP_FAILED) { size = 0; open = false; }
+        else {
+          data   = static_cast<char *>(p);
+          mapped = true;
+          #if defined(MADV_SEQUENTIAL)
+          madvise(p, size, MADV_SEQUENTIAL);
+          #endif
+        }
+      }
+    }
+    close(handle);
+
+    #else
+    std::ifstream file(file_name, std::ios::in | std::ios::binary);
+    if (!file) return;
+
+    file.seekg(0, std::ios::end);
+    size = static_cast<std::size_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+
+    data = new char[size + 1];
+    if (!file.read(data, size)) {
+      delete [] data;
+      data = 0;
+      size = 0;
+      return;
+    }
+    open = true;
+    #endif
+  }
+
+
+  LineReader::~LineReader()
+  {
+    #if eOPSYS == ePOSIX
+    if (mapped) munmap(data, size);
+    #endif
+    if (!mapped) delete [] data;
+  }
+
+
+  /*! \param line Set to point at the first character of the line.
+
+      \param length Set to the number of characters in the line, not
+      including the newline.
+
+      \return False if there are no more lines in the file. In that case
+      line and length are not changed.
+  */
+  bool LineReader::next(const char *&line, int &length)
+  {
+    if (position >= size) return false;
+
+    const char *start = data + position;
+    const char *end   =
+      static_cast<const char *>(std::memchr(start, '\n', size - position));
+
+    if (end == 0) {
+      end      = data + size;
+      position = size;
+    }
+    else {
+      position = static_cast<std::size_t>(end - data) + 1;
+    }
+
+    line   = start;
+    length = static_cast<int>(end - start);
+    line_count++;
+    return true;
+  }
+
+}
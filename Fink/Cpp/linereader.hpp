@@ -0,0 +1,79 @@
+/****************************************************************************
+FILE          : linereader.hpp
+LAST REVISED  : 2026-10-19
+SUBJECT       : Interface to a class that reads the lines of a file.
+PROGRAMMER    : (C) Copyright 2026 by Peter Chapin
+
+A LineReader provides the lines of an entire file one at a time without
+allocating any memory for the individual lines. This is useful when
+processing large text inputs (OJ files, response files) where the cost
+of building a String for every line would dominate.
+
+
+LICENSE
+
+This program is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2 of the License, or (at your
+option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANT-
+ABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+Please send comments or bug reports pertaining to this file to
+
+     Peter Chapin
+     Vermont Technical College
+     Randolph Center, VT 05061
+     pchapin@ecet.vtc.edu
+****************************************************************************/
+
+#ifndef LINEREADER_H
+#define LINEREADER_H
+
+#include "environ.hpp"
+#include <cstddef>
+
+namespace pcc {
+
+  //! Reads the lines of a file without allocating memory per line.
+  class LineReader {
+  public:
+
+    //! Open the named file and prepare to read its lines.
+    explicit LineReader(const char *file_name);
+
+    //! Release the file's contents.
+   ~LineReader();
+
+    //! Return true if the file was opened and read successfully.
+    bool is_open() const { return open; }
+
+    //! Get the next line of the file.
+    bool next(const char *&line, int &length);
+
+    //! Return the line number of the line most recently returned.
+    int line_number() const { return line_count; }
+
+  private:
+    char        *data;         // The contents of the file.
+    std::size_t  size;         // The number of characters in data.
+    std::size_t  position;     // Offset to the start of the next line.
+    bool         mapped;       // True if data is a memory mapping.
+    bool         open;
+    int          line_count;
+
+    // LineReaders can't be copied.
+    LineReader(const LineReader &);
+    LineReader &operator=(const LineReader &);
+  };
+
+}
+
+#endif
@@ -1,6 +1,6 @@
 /****************************************************************************
 FILE          : str.cpp
-LAST REVISED  : 2003-05-18
+LAST REVISED  : 2026-10-19
 SUBJECT       : Implementation of a Rexx-like string class.
 PROGRAMMER    : (C) Copyright 2003 by Peter Chapin
 
@@ -24,6 +24,34 @@ TO DO
 
 REVISION HISTORY
 
++ 2026-10-19: Added StringBuilder. The padding methods, copy(), and the
+  concatenation operators now build their results with it so each one
+  allocates a single workspace of the right size. Previously copy() used
+  repeated strcat() calls and was O(n^2) in the number of copies.
+
++ 2026-10-19: Added hash(). The value is computed on first use and
+  cached in the string_node so copies sharing the node get it for free.
+  Equality tests use cached hash values, when available, to reject
+  unequal strings quickly.
+
++ 2026-10-19: String nodes and workspaces of up to 256 bytes are now
+  recycled through per-thread free lists organized by size class. Added
+  allocation counters so the effect can be measured.
+
++ 2026-10-19: The extraction operator now reads lines in large chunks
+  and allocates the string's representation once. Previously each
+  character was appended individually making long lines O(n^2).
+
++ 2026-10-19: The search methods now use memchr()/memrchr() for single
+  characters. Substrings are located with a vectorized filter on the
+  first and last characters of the needle. Long needles fall back to the
+  Two-Way algorithm if the filter performs poorly so the search time is
+  linear in the worst case.
+
++ 2026-10-19: The word oriented methods now use a precompiled DelimiterSet
+  instead of calling strchr() for every character. When SSE2 is available
+  runs of non-delimiters are skipped sixteen characters at a time.
+
 + 2003-05-18: Fixed severe bugs in the thread safety of this class. See
   the documentation (below) for more information. Note that this imple-
   mentation does not allow for much parallelism. Fixing that is difficult
@@ -66,12 +94,19 @@ Please send comments or bug reports pertaining to this file to
 #include <cstring>
 #include <iostream>
 #include <memory>
+#include <vector>
 #include "str.hpp"
 
 #if defined(pMULTITHREADED)
 #include "sem.h"
 #endif
 
+// The block scanning code relies on gcc's bit scanning builtins.
+#if eCOMPILER == eGCC && defined(__SSE2__)
+#define pSTRING_SSE2
+#include <emmintrin.h>
+#endif
+
 /*! \class pcc::String
 
   <p>Class String has features that are similar to those offered by the
@@ -117,6 +152,12 @@ Please send comments or bug reports pertaining to this file to
   low overhead, O(1) operations. A string's representation is only
   copied when necessary (on demand).</p>
 
+  <p>The memory for string nodes and for small workspaces is recycled
+  through free lists kept separately by each thread. Most operations on
+  short strings therefore do not call the global operator new at all.
+  The static method counters() reports the allocation requests made by
+  the calling thread.</p>
+
   <p>These strings are thread safe in the sense that multiple threads
   can manipulate the same string without causing undefined behavior. If
   a thread reads a string's value while that value is being updated by a
@@ -148,20 +189,406 @@ namespace pcc {
   //           Internally Linked Functions
   //-------------------------------------------------
 
-  static bool is_white(int ch, const char *white)
+  //-------------------------------------
+  //           Memory Management
+  //-------------------------------------
+
+  // Small blocks are recycled through free lists, one list for each size
+  // class. Each thread has its own lists so no locking is needed. A block
+  // freed by a thread other than the one that allocated it simply joins
+  // the freeing thread's list. Each block is a separate allocation from
+  // operator new so blocks can always be returned to the system.
+  //
+  const int         CLASS_COUNT = 5;
+  const std::size_t CLASS_SIZES[CLASS_COUNT] = { 16, 32, 64, 128, 256 };
+  const int         CACHE_LIMIT = 1024;   // Blocks kept per size class.
+
+  struct free_block {
+    free_block *next;
+  };
+
+  struct block_pool {
+    free_block *free_list [CLASS_COUNT];
+    int         free_count[CLASS_COUNT];
+    bool        closed;
+    String::allocation_counters counters;
+
+    // Returns the cached blocks to the system when the thread ends. Note
+    // that Strings with static storage duration may be destroyed after
+    // this. The closed flag sends their memory directly to the system.
+    //
+   ~block_pool()
+    {
+      for (int i = 0; i < CLASS_COUNT; ++i) {
+        while (free_list[i] != 0) {
+          free_block *block = free_list[i];
+          free_list[i] = block->next;
+          ::operator delete(block);
+        }
+        free_count[i] = 0;
+      }
+      closed = true;
+    }
+  };
+
+  // Zero initialized. No constructor is needed.
+  static thread_local block_pool pool;
+
+
+  // Returns the size class for a block of the given size or CLASS_COUNT
+  // if the block is too large to be pooled.
+  //
+  static int size_class(std::size_t size)
   {
-    // If the user is trying to use a special kind of whitespace...
-    if (white != 0) {
-      if (std::strchr(white, ch) != 0) return true;
-        return false;
+    int i = 0;
+    while (i < CLASS_COUNT && size > CLASS_SIZES[i]) ++i;
+    return i;
+  }
+
+
+  static void *pool_allocate(std::size_t size)
+  {
+    block_pool &local = pool;
+    local.counters.requests++;
+    local.counters.bytes += size;
+
+    int index = size_class(size);
+    if (index < CLASS_COUNT && !local.closed) {
+      free_block *block = local.free_list[index];
+      if (block != 0) {
+        local.free_list[index] = block->next;
+        local.free_count[index]--;
+        local.counters.pool_hits++;
+        return block;
+      }
+
+      // Allocate the full class size so the block can be reused by any
+      // request in this class.
+      size = CLASS_SIZES[index];
     }
+    local.counters.system_calls++;
+    return ::operator new(size);
+  }
 
-    // Otherwise use the default.
-    if (ch == ' '  || ch == '\t' || ch == '\v' ||
-        ch == '\r' || ch == '\n' || ch == '\f')
-      return true;
 
-    return false;
+  static void pool_release(void *memory, std::size_t size)
+  {
+    block_pool &local = pool;
+
+    int index = size_class(size);
+    if (index < CLASS_COUNT && !local.closed && local.free_count[index] < CACHE_LIMIT) {
+      free_block *block = static_cast<free_block *>(memory);
+      block->next = local.free_list[index];
+      local.free_list[index] = block;
+      local.free_count[index]++;
+      return;
+    }
+    ::operator delete(memory);
+  }
+
+
+  // Workspaces carry their size in a header just before the characters so
+  // that they can be released without the caller knowing the size.
+  //
+  const std::size_t WORKSPACE_HEADER = sizeof(std::size_t);
+
+  // Returns a workspace that can hold size characters (including the null
+  // character).
+  //
+  static char *allocate_workspace(std::size_t size)
+  {
+    size += WORKSPACE_HEADER;
+    char *block = static_cast<char *>(pool_allocate(size));
+    std::memcpy(block, &size, WORKSPACE_HEADER);
+    return block + WORKSPACE_HEADER;
+  }
+
+
+  static void release_workspace(char *workspace)
+  {
+    char *block = workspace - WORKSPACE_HEADER;
+    std::size_t size;
+    std::memcpy(&size, block, WORKSPACE_HEADER);
+    pool_release(block, size);
+  }
+
+
+  #if defined(pSTRING_SSE2)
+  // Returns a bit mask with one bit set for each character in the aligned
+  // block that is either null or equal to one of the targets. The block
+  // may extend past the end of the string (but never past the end of the
+  // page) so address sanitizer checking is disabled here.
+  //
+  __attribute__((no_sanitize_address))
+  static unsigned match_block(
+    const char *block, const __m128i *targets, int target_count)
+  {
+    __m128i data  = _mm_load_si128(reinterpret_cast<const __m128i *>(block));
+    __m128i found = _mm_cmpeq_epi8(data, _mm_setzero_si128());
+    for (int i = 0; i < target_count; ++i) {
+      found = _mm_or_si128(found, _mm_cmpeq_epi8(data, targets[i]));
+    }
+    return static_cast<unsigned>(_mm_movemask_epi8(found));
+  }
+  #endif
+
+
+  //-------------------------------------
+  //           Class DelimiterSet
+  //-------------------------------------
+
+  /*! \param delimiters Pointer to a string containing the delimiter
+      characters. If this pointer is null the set contains the white
+      space characters: space, tab, vertical tab, carriage return,
+      newline, and form feed.
+
+      The null character is never a member of the set.
+  */
+  DelimiterSet::DelimiterSet(const char *delimiters)
+    : member_count(0)
+  {
+    std::memset(table, 0, sizeof(table));
+    if (delimiters == 0) delimiters = " \t\v\r\n\f";
+    while (*delimiters) add(*delimiters++);
+  }
+
+
+  void DelimiterSet::add(char ch)
+  {
+    if (contains(ch)) return;
+
+    unsigned char index = static_cast<unsigned char>(ch);
+    table[index >> 5] |= 1U << (index & 31);
+
+    if (member_count < 0) return;
+    if (member_count == MAX_MEMBERS) member_count = -1;
+    else members[member_count++] = ch;
+  }
+
+
+  /*! If p points at a non-delimiter (or at the null character) it is
+      returned unchanged.
+  */
+  const char *DelimiterSet::skip(const char *p) const
+  {
+    while (contains(*p)) p++;
+    return p;
+  }
+
+
+  /*! The null character at the end of the string always stops the
+      search. Thus this method returns a pointer to the end of the
+      string if no delimiter is found.
+  */
+  const char *DelimiterSet::find(const char *p) const
+  {
+    #if defined(pSTRING_SSE2)
+    // Small sets are compared against sixteen characters at a time. The
+    // loads are aligned so they never cross into a page that does not
+    // also contain part of the string.
+    //
+    if (member_count >= 0) {
+      __m128i targets[MAX_MEMBERS];
+      for (int i = 0; i < member_count; ++i) {
+        targets[i] = _mm_set1_epi8(members[i]);
+      }
+
+      std::size_t  skew  = reinterpret_cast<std::size_t>(p) & 15;
+      const char  *block = p - skew;
+      unsigned     mask  = match_block(block, targets, member_count) >> skew;
+      if (mask != 0) return p + __builtin_ctz(mask);
+
+      for (;;) {
+        block += 16;
+        mask = match_block(block, targets, member_count);
+        if (mask != 0) return block + __builtin_ctz(mask);
+      }
+    }
+    #endif
+
+    while (*p && !contains(*p)) p++;
+    return p;
+  }
+
+
+  //----------------------------------------
+  //           Substring Searching
+  //----------------------------------------
+
+  // Candidate positions are verified with memcmp() which is O(n*m) in the
+  // worst case. Needles longer than this switch to the Two-Way algorithm
+  // once the verification work becomes large relative to the amount of
+  // the haystack scanned. Shorter needles bound m themselves.
+  //
+  static const std::size_t SHORT_NEEDLE = 32;
+  static const std::size_t VERIFY_SLACK = 4096;
+
+  // Computes a critical factorization of the needle using the maximal
+  // suffix method of Crochemore and Perrin. Returns the position of the
+  // factorization and sets period to the period of the right half.
+  //
+  static std::size_t critical_factorization(
+    const unsigned char *needle, std::size_t needle_length, std::size_t &period)
+  {
+    const std::size_t NONE = static_cast<std::size_t>(-1);
+    std::size_t max_suffix, max_suffix_rev, j, k, p;
+
+    // Maximal suffix under the normal ordering.
+    max_suffix = NONE; j = 0; k = p = 1;
+    while (j + k < needle_length) {
+      unsigned char a = needle[j + k];
+      unsigned char b = needle[max_suffix + k];
+      if (a < b) { j += k; k = 1; p = j - max_suffix; }
+      else if (a == b) {
+        if (k != p) k++;
+        else { j += p; k = 1; }
+      }
+      else { max_suffix = j++; k = p = 1; }
+    }
+    period = p;
+
+    // Maximal suffix under the reversed ordering.
+    max_suffix_rev = NONE; j = 0; k = p = 1;
+    while (j + k < needle_length) {
+      unsigned char a = needle[j + k];
+      unsigned char b = needle[max_suffix_rev + k];
+      if (b < a) { j += k; k = 1; p = j - max_suffix_rev; }
+      else if (a == b) {
+        if (k != p) k++;
+        else { j += p; k = 1; }
+      }
+      else { max_suffix_rev = j++; k = p = 1; }
+    }
+
+    // The longer of the two suffixes gives the critical factorization.
+    if (max_suffix_rev + 1 < max_suffix + 1) return max_suffix + 1;
+    period = p;
+    return max_suffix_rev + 1;
+  }
+
+
+  // Locates needle in haystack using the Two-Way algorithm. Both lengths
+  // are known and the needle is not longer than the haystack.
+  //
+  static const char *two_way_search(
+    const char *haystack, std::size_t haystack_length,
+    const char *needle,   std::size_t needle_length)
+  {
+    const std::size_t NONE = static_cast<std::size_t>(-1);
+    const unsigned char *h = reinterpret_cast<const unsigned char *>(haystack);
+    const unsigned char *n = reinterpret_cast<const unsigned char *>(needle);
+    std::size_t period;
+    std::size_t suffix = critical_factorization(n, needle_length, period);
+    std::size_t i, j;
+
+    // If the left half of the needle repeats with the period of the right
+    // half we can remember how much of the needle is known to match.
+    //
+    if (std::memcmp(n, n + period, suffix) == 0) {
+      std::size_t memory = 0;
+      j = 0;
+      while (j <= haystack_length - needle_length) {
+        i = (suffix < memory) ? memory : suffix;
+        while (i < needle_length && n[i] == h[i + j]) i++;
+        if (i >= needle_length) {
+          i = suffix - 1;
+          while (memory < i + 1 && n[i] == h[i + j]) i--;
+          if (i + 1 < memory + 1) return haystack + j;
+          j += period;
+          memory = needle_length - period;
+        }
+        else {
+          j += i - suffix + 1;
+          memory = 0;
+        }
+      }
+    }
+
+    // Otherwise the halves are distinct and a larger shift is safe.
+    else {
+      period = ((suffix > needle_length - suffix) ? suffix : needle_length - suffix) + 1;
+      j = 0;
+      while (j <= haystack_length - needle_length) {
+        i = suffix;
+        while (i < needle_length && n[i] == h[i + j]) i++;
+        if (i >= needle_length) {
+          i = suffix - 1;
+          while (i != NONE && n[i] == h[i + j]) i--;
+          if (i == NONE) return haystack + j;
+          j += period;
+        }
+        else {
+          j += i - suffix + 1;
+        }
+      }
+    }
+    return 0;
+  }
+
+
+  // Locates needle in haystack. Both lengths are known. Returns a null
+  // pointer if the needle is not found.
+  //
+  static const char *search(
+    const char *haystack, std::size_t haystack_length,
+    const char *needle,   std::size_t needle_length)
+  {
+    if (needle_length == 0) return haystack;
+    if (needle_length > haystack_length) return 0;
+    if (needle_length == 1) {
+      return static_cast<const char *>(
+        std::memchr(haystack, *needle, haystack_length));
+    }
+
+    std::size_t last_start = haystack_length - needle_length;
+    std::size_t verified   = 0;   // Characters examined by memcmp().
+    std::size_t i = 0;
+
+    #if defined(pSTRING_SSE2)
+    // Find candidate positions sixteen at a time by comparing both the
+    // first and the last character of the needle. Only candidates that
+    // match at both ends are verified.
+    //
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last  = _mm_set1_epi8(needle[needle_length - 1]);
+
+    for ( ; i + 16 <= last_start + 1; i += 16) {
+      if (needle_length > SHORT_NEEDLE && verified > i + VERIFY_SLACK)
+        break;
+
+      const __m128i block_first = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(haystack + i));
+      const __m128i block_last  = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(haystack + i + needle_length - 1));
+      unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))));
+
+      while (mask != 0) {
+        std::size_t candidate = i + __builtin_ctz(mask);
+        if (std::memcmp(haystack + candidate + 1, needle + 1, needle_length - 2) == 0)
+          return haystack + candidate;
+        verified += needle_length;
+        mask &= mask - 1;
+      }
+    }
+    #endif
+
+    // Check any remaining positions one at a time.
+    for ( ; i <= last_start; i++) {
+      if (needle_length > SHORT_NEEDLE && verified > i + VERIFY_SLACK)
+        break;
+
+      if (haystack[i] == needle[0] &&
+          haystack[i + needle_length - 1] == needle[needle_length - 1]) {
+        if (std::memcmp(haystack + i + 1, needle + 1, needle_length - 2) == 0)
+          return haystack + i;
+        verified += needle_length;
+      }
+    }
+    if (i > last_start) return 0;
+
+    // Too much time was spent verifying. Finish with a linear search.
+    return two_way_search(haystack + i, haystack_length - i, needle, needle_length);
   }
 
 
@@ -180,6 +607,11 @@ namespace pcc {
 
     // Is this first comparison worthwhile?
     if (left.rep == right.rep) return true;
+
+    // Strings with different hash values can't be equal.
+    if (left.rep->hashed && right.rep->hashed &&
+        left.rep->hash_value != right.rep->hash_value) return false;
+
     return (std::strcmp(left.rep->workspace, right.rep->workspace) == 0);
   }
 
@@ -217,19 +649,65 @@ namespace pcc {
       reached. The string is expanded as necessary. Note that this
       funtion does not add the newline to the string although it does
       remove the newline from the input.
+
+      As with std::getline, if EOF is reached after reading at least one
+      character, only eofbit is set on the stream. Thus a final line
+      without a newline can be processed in the usual way.
   */
   std::istream &operator>>(std::istream &is, String &right)
   {
-    char   ch;
-    String temp;
+    // Most lines fit in the chunk. Longer lines are accumulated in the
+    // overflow buffer until the end of the line is found.
+    //
+    char              chunk[256];
+    std::vector<char> overflow;
+    std::streamsize   chunk_length = 0;
+
+    for (;;) {
+      is.getline(chunk, sizeof(chunk));
+      std::streamsize count = is.gcount();
+
+      // The chunk filled before the end of the line was found.
+      if (is.fail() && !is.eof()) {
+        overflow.insert(overflow.end(), chunk, chunk + count);
+        is.clear(is.rdstate() & ~std::ios::failbit);
+        continue;
+      }
 
-    // This is sort of inefficient. Do I care? Not right now.
-    while (is.get(ch)) {
-      if (ch == '\n') break;
-      temp.append(ch);
+      // Nothing was read by this call. That is only a failure if nothing
+      // was read by any previous call either.
+      //
+      if (is.fail()) {
+        if (!overflow.empty()) is.clear(is.rdstate() & ~std::ios::failbit);
+        break;
+      }
+
+      // Otherwise the line is complete. The newline, if any, was counted.
+      chunk_length = is.eof() ? count : count - 1;
+      break;
     }
 
-    right = temp;
+    std::size_t length = overflow.size() + chunk_length;
+    std::unique_ptr<String::string_node> new_node(new String::string_node);
+    new_node->workspace = allocate_workspace(length + 1);
+    if (!overflow.empty())
+      std::memcpy(new_node->workspace, &overflow[0], overflow.size());
+    std::memcpy(new_node->workspace + overflow.size(), chunk, chunk_length);
+    new_node->workspace[length] = '\0';
+
+    // Make sure I am the only one using this string's representation.
+    #if defined(pMULTITHREADED)
+    mutex_sem::grabber lock(string_lock);
+    #endif
+
+    if (right.rep->count > 1) right.rep->count--;
+    else {
+      release_workspace(right.rep->workspace);
+      delete right.rep;
+    }
+    right.rep = new_node.get();
+    new_node.release();
+
     return is;
   }
 
@@ -237,10 +715,39 @@ namespace pcc {
   //           Methods
   //----------------------------
 
+  void *String::string_node::operator new(std::size_t size)
+  {
+    return pool_allocate(size);
+  }
+
+
+  void String::string_node::operator delete(void *p, std::size_t size)
+  {
+    if (p != 0) pool_release(p, size);
+  }
+
+
+  /*! The counters are kept per thread so that maintaining them requires
+      no synchronization. To measure the allocation done by an operation,
+      reset the counters, perform the operation, and then read the
+      counters in the same thread.
+  */
+  String::allocation_counters String::counters()
+  {
+    return pool.counters;
+  }
+
+
+  void String::reset_counters()
+  {
+    std::memset(&pool.counters, 0, sizeof(pool.counters));
+  }
+
+
   String::String()
   {
      std::auto_ptr<string_node> new_node(new string_node);
-     new_node->workspace = new char[1];
+     new_node->workspace = allocate_workspace(1);
     *new_node->workspace = '\0';
      rep = new_node.get();
      new_node.release();
@@ -264,7 +771,7 @@ namespace pcc {
   String::String(const char *existing)
   {
     std::auto_ptr<string_node> new_node(new string_node);
-    new_node->workspace = new char[std::strlen(existing) + 1];
+    new_node->workspace = allocate_workspace(std::strlen(existing) + 1);
     std::strcpy(new_node->workspace, existing);
     rep = new_node.get();
     new_node.release();
@@ -274,7 +781,7 @@ namespace pcc {
   String::String(char existing)
   {
     std::auto_ptr<string_node> new_node(new string_node);
-    new_node->workspace = new char[2];
+    new_node->workspace = allocate_workspace(2);
     new_node->workspace[0] = existing;
     new_node->workspace[1] = '\0';
     rep = new_node.get();
@@ -297,8 +804,8 @@ namespace pcc {
   
     if (rep->count > 1) rep->count--;
     else {
-      delete [] rep->workspace;
-      delete    rep;
+      release_workspace(rep->workspace);
+      delete rep;
     }
   }
 
@@ -314,8 +821,8 @@ namespace pcc {
 
     if (rep->count > 1) rep->count--;
     else {
-      delete [] rep->workspace;
-      delete    rep;
+      release_workspace(rep->workspace);
+      delete rep;
     }
 
     rep = other.rep;
@@ -330,7 +837,7 @@ namespace pcc {
     if (other == 0) return *this;
 
     std::auto_ptr<string_node> new_node(new string_node);
-    new_node->workspace = new char[std::strlen(other) + 1];
+    new_node->workspace = allocate_workspace(std::strlen(other) + 1);
     std::strcpy(new_node->workspace, other);
   
     // Make sure I am the only one using this string's representation.
@@ -340,8 +847,8 @@ namespace pcc {
 
     if (rep->count > 1) rep->count--;
     else {
-      delete [] rep->workspace;
-      delete    rep;
+      release_workspace(rep->workspace);
+      delete rep;
     }
     rep = new_node.get();
     new_node.release();
@@ -364,6 +871,40 @@ namespace pcc {
   }
 
 
+  /*! The hash value is computed the first time it is needed and then
+      remembered. Strings that share a representation also share the
+      hash value. The value is the same as that returned by
+      hash(const char *) for the same characters.
+  */
+  std::size_t String::hash() const
+  {
+    #if defined(pMULTITHREADED)
+    mutex_sem::grabber lock(string_lock);
+    #endif
+
+    if (!rep->hashed) {
+      rep->hash_value = hash(rep->workspace);
+      rep->hashed     = true;
+    }
+    return rep->hash_value;
+  }
+
+
+  /*! This function uses the 64 bit FNV-1a algorithm. It allows clients
+      to look up String keys using C-style strings without creating a
+      String.
+  */
+  std::size_t String::hash(const char *text)
+  {
+    unsigned long long value = 14695981039346656037ULL;
+    for (const unsigned char *p = reinterpret_cast<const unsigned char *>(text); *p; ++p) {
+      value ^= *p;
+      value *= 1099511628211ULL;
+    }
+    return static_cast<std::size_t>(value);
+  }
+
+
   String &String::append(const String &other)
   {
     // Make sure I am the only one using either string's representation.
@@ -374,15 +915,15 @@ namespace pcc {
     int count =
       std::strlen(rep->workspace) + std::strlen(other.rep->workspace);
     std::auto_ptr<string_node> new_node(new string_node);
-    new_node->workspace = new char[count + 1];
+    new_node->workspace = allocate_workspace(count + 1);
 
     std::strcpy(new_node->workspace, rep->workspace);
     std::strcat(new_node->workspace, other.rep->workspace);
 
     if (rep->count > 1) rep->count--;
     else {
-      delete [] rep->workspace;
-      delete    rep;
+      release_workspace(rep->workspace);
+      delete rep;
     }
     rep = new_node.get();
     new_node.release();
@@ -399,15 +940,15 @@ namespace pcc {
 
     int count = std::strlen(rep->workspace) + std::strlen(other);
     std::auto_ptr<string_node> new_node(new string_node);
-    new_node->workspace = new char[count + 1];
+    new_node->workspace = allocate_workspace(count + 1);
 
     std::strcpy(new_node->workspace, rep->workspace);
     std::strcat(new_node->workspace, other);
 
     if (rep->count > 1) rep->count--;
     else {
-      delete [] rep->workspace;
-      delete    rep;
+      release_workspace(rep->workspace);
+      delete rep;
     }
     rep = new_node.get();
     new_node.release();
@@ -424,7 +965,7 @@ namespace pcc {
 
     int count = std::strlen(rep->workspace) + 1;
     std::auto_ptr<string_node> new_node(new string_node);
-    new_node->workspace = new char[count + 1];
+    new_node->workspace = allocate_workspace(count + 1);
 
     std::strcpy(new_node->workspace, rep->workspace);
     new_node->workspace[count - 1] = other;
@@ -432,8 +973,8 @@ namespace pcc {
 
     if (rep->count > 1) rep->count--;
     else {
-      delete [] rep->workspace;
-      delete    rep;
+      release_workspace(rep->workspace);
+      delete rep;
     }
     rep = new_node.get();
     new_node.release();
@@ -448,7 +989,7 @@ namespace pcc {
   void String::erase()
   {
     std::auto_ptr<string_node> new_node(new string_node);
-    new_node->workspace = new char[1];
+    new_node->workspace = allocate_workspace(1);
    *new_node->workspace = '\0';
 
     // Make sure I am the only one using this string's representation.
@@ -458,7 +999,7 @@ namespace pcc {
 
     if (rep->count > 1) rep->count--;
     else {
-      delete [] rep->workspace;
+      release_workspace(rep->workspace);
       delete rep;
     }
     rep = new_node.get();
@@ -485,32 +1026,24 @@ namespace pcc {
     mutex_sem::grabber lock(string_lock);
     #endif
 
-    // A place to put the answer.
-    String result;
-
     // Ignore attempts to use a negative count.
-    if (length <= 0) return result;
+    if (length <= 0) return String();
 
     int current_length = std::strlen(rep->workspace);
+    StringBuilder result(length);
 
     // If we need to make the string shorter...
     if (length < current_length) {
-      char *temp = new char[length + 1];
-      std::strcpy(temp, &rep->workspace[current_length - length]);
-      delete [] result.rep->workspace;
-      result.rep->workspace = temp;
+      result.append(&rep->workspace[current_length - length], length);
     }
 
     // otherwise we need to make the string longer or the same size...
     else {
-      char *temp = new char[length + 1];
-      std::memset(temp, pad, length - current_length);
-      std::strcpy(&temp[length - current_length], rep->workspace);
-      delete [] result.rep->workspace;
-      result.rep->workspace = temp;
+      result.append(pad, length - current_length);
+      result.append(rep->workspace, current_length);
     }
 
-    return result;
+    return result.finish();
   }
 
 
@@ -533,34 +1066,24 @@ namespace pcc {
     mutex_sem::grabber lock(string_lock);
     #endif
 
-    // A place to put the answer.
-    String result;
-
     // Ignore attempts to use a negative count.
-    if (length <= 0) return result;
+    if (length <= 0) return String();
 
     int current_length = std::strlen(rep->workspace);
+    StringBuilder result(length);
 
     // If we need to make the string shorter...
     if (length < current_length) {
-      char *temp = new char[length + 1];
-      std::strncpy(temp, rep->workspace, length);
-      temp[length] = '\0';
-      delete [] result.rep->workspace;
-      result.rep->workspace = temp;
+      result.append(rep->workspace, length);
     }
 
     // otherwise we need to make the string longer...
     else {
-      char *temp = new char[length + 1];
-      std::strcpy(temp, rep->workspace);
-      std::memset(&temp[current_length], pad, length - current_length);
-      temp[length] = '\0';
-      delete [] result.rep->workspace;
-      result.rep->workspace = temp;
+      result.append(rep->workspace, current_length);
+      result.append(pad, length - current_length);
     }
 
-    return result;
+    return result.finish();
   }
 
 
@@ -586,11 +1109,8 @@ namespace pcc {
     mutex_sem::grabber lock(string_lock);
     #endif
 
-    // A place to put the answer.
-    String result;
-
     // Ignore attempts to use a negative length.
-    if (length <= 0) return result;
+    if (length <= 0) return String();
 
     int current_length = std::strlen(rep->workspace);
 
@@ -602,20 +1122,14 @@ namespace pcc {
     }
 
     // Otherwise I have to do real work.
-    else {
-      int left_side  = (length - current_length)/2;
-      int right_side = length - current_length - left_side;
-
-      char *temp = new char[length + 1];
-      std::memset(temp, pad, left_side);
-      std::strcpy(&temp[left_side], rep->workspace);
-      std::memset(&temp[left_side + current_length], pad, right_side);
-      temp[length] = '\0';
-      delete [] result.rep->workspace;
-      result.rep->workspace = temp;
-    }
-
-    return result;
+    int left_side  = (length - current_length)/2;
+    int right_side = length - current_length - left_side;
+
+    StringBuilder result(length);
+    result.append(pad, left_side);
+    result.append(rep->workspace, current_length);
+    result.append(pad, right_side);
+    return result.finish();
   }
 
 
@@ -634,20 +1148,13 @@ namespace pcc {
     mutex_sem::grabber lock(string_lock);
     #endif
 
-    // A place to put the answer.
-    String result;
-
     // Ignore attempts to use a negative count.
-    if (count < 0) return result;
+    if (count < 0) return String();
 
-    char *temp = new char[count * std::strlen(rep->workspace) + 1];
-
-    temp[0] = '\0';
-    for (int i = 0; i < count; i++) std::strcat(temp, rep->workspace);
-    delete [] result.rep->workspace;
-    result.rep->workspace = temp;
-
-    return result;
+    int current_length = std::strlen(rep->workspace);
+    StringBuilder result(count * current_length);
+    for (int i = 0; i < count; i++) result.append(rep->workspace, current_length);
+    return result.finish();
   }
 
 
@@ -690,10 +1197,10 @@ namespace pcc {
     if (count > max_count) count = max_count;
 
     // Now do the work.
-    char *temp = new char[current_length - count + 1];
+    char *temp = allocate_workspace(current_length - count + 1);
     std::memcpy(temp, rep->workspace, offset);
     std::strcpy(&temp[offset], &rep->workspace[offset + count]);
-    delete [] result.rep->workspace;
+    release_workspace(result.rep->workspace);
     result.rep->workspace = temp;
 
     return result;
@@ -744,12 +1251,12 @@ namespace pcc {
     if (count > incoming_length) count = incoming_length;
 
     // Now do the work.
-    char *temp = new char [current_length + count + 1];
+    char *temp = allocate_workspace(current_length + count + 1);
     std::memcpy(temp, rep->workspace, offset);
       // Does memcpy() freak if you copy 0 bytes?
     std::memcpy(&temp[offset], incoming.rep->workspace, count);
     std::strcpy(&temp[offset + count], &rep->workspace[offset]);
-    delete [] result.rep->workspace;
+    release_workspace(result.rep->workspace);
     result.rep->workspace = temp;
 
     return result;
@@ -779,18 +1286,21 @@ namespace pcc {
     // didn't find anything. Note that this function *does* allow the
     // caller to locate the null character at the end of the string.
     //
-    if (offset < 0 || (std::size_t)offset > std::strlen(rep->workspace))
+    std::size_t current_length = std::strlen(rep->workspace);
+    if (offset < 0 || static_cast<std::size_t>(offset) > current_length)
       return 0;
 
+    if (needle == '\0') return int(current_length) + 1;
+
     // Locate the character.
-    const char *p = rep->workspace + offset;
-    p = std::strchr(p, needle);
+    const void *p = std::memchr(
+      rep->workspace + offset, needle, current_length - offset);
 
     // If we didn't find it, return error.
     if (p == 0) return 0;
 
     // Otherwise return the offset to the character.
-    return int(p - rep->workspace) + 1;
+    return int(static_cast<const char *>(p) - rep->workspace) + 1;
   }
 
 
@@ -813,12 +1323,14 @@ namespace pcc {
     // If we are starting off the end of the string, then obviously we
     // didn't find anything.
     // 
-    if (offset < 0 || (std::size_t)offset > std::strlen(rep->workspace))
+    std::size_t current_length = std::strlen(rep->workspace);
+    if (offset < 0 || static_cast<std::size_t>(offset) > current_length)
       return 0;
 
     // Locate the substring.
-    const char *p = rep->workspace + offset;
-    p = std::strstr(p, needle);
+    const char *p = search(
+      rep->workspace + offset, current_length - offset,
+      needle, std::strlen(needle));
 
     // If we didn't find it, return error.
     if (p == 0) return 0;
@@ -853,15 +1365,15 @@ namespace pcc {
     if (offset < 0) return 0;
     if (offset > current_length) offset = current_length;
 
-    const char *p = rep->workspace + offset;
-
-    // Now back up. If we find the character, return the offset to it.
-    while (p >= rep->workspace) {
-      if (*p == needle) return int(p - rep->workspace) + 1;
-      p--;
-        // Is it technically ok to step a pointer one off the beginning
-        // of an array? (NO!)
+    // Search backwards from offset, inclusive.
+    #if eOPSYS == ePOSIX && defined(__GLIBC__)
+    const void *p = memrchr(rep->workspace, needle, offset + 1);
+    if (p != 0) return int(static_cast<const char *>(p) - rep->workspace) + 1;
+    #else
+    for (const char *p = rep->workspace + offset + 1; p != rep->workspace; ) {
+      if (*--p == needle) return int(p - rep->workspace) + 1;
     }
+    #endif
 
     // If we got here, then we didn't find the character.
     return 0;
@@ -928,10 +1440,10 @@ namespace pcc {
     // Otherwise there is something to do.
     else {
       int length = static_cast<int>(end - start) + 1;
-      char *temp = new char [length + 1];
+      char *temp = allocate_workspace(length + 1);
       std::memcpy(temp, start, length);
       temp[length] = '\0';
-      delete [] result.rep->workspace;
+      release_workspace(result.rep->workspace);
       result.rep->workspace = temp;
     }
 
@@ -939,6 +1451,49 @@ namespace pcc {
   }
 
 
+  /*! \param mode Use 'L' to strip leading characters, 'T' to strip
+      trailing characters, or 'B' to strip both leading and trailing
+      characters.
+
+      \param kill_set The characters to strip. All leading (or trailing
+      or both) members of this set are removed.
+
+      \return A new string containing the result. The original string is
+      unchanged.
+  */
+  String String::strip(char mode, const DelimiterSet &kill_set) const
+  {
+    // Make sure I am the only one using this string's representation.
+    #if defined(pMULTITHREADED)
+    mutex_sem::grabber lock(string_lock);
+    #endif
+
+    // A place to put the answer.
+    String result;
+
+    const char *start = rep->workspace;
+    const char *end   = std::strchr(rep->workspace, '\0');
+
+    if (mode == 'L' || mode == 'B') start = kill_set.skip(start);
+
+    // Here end points just past the last character that is retained.
+    if (mode == 'T' || mode == 'B') {
+      while (end > start && kill_set.contains(*(end - 1))) end--;
+    }
+
+    if (start == end) return result;
+
+    int length = static_cast<int>(end - start);
+    char *temp = allocate_workspace(length + 1);
+    std::memcpy(temp, start, length);
+    temp[length] = '\0';
+    release_workspace(result.rep->workspace);
+    result.rep->workspace = temp;
+
+    return result;
+  }
+
+
   /*! \param offset The starting index for the substring.
 
       \param count The length of the substring
@@ -972,11 +1527,11 @@ namespace pcc {
     if (count > current_length - offset) count = current_length - offset;
 
     // Create the new string.
-    char *temp = new char[count + 1];
+    char *temp = allocate_workspace(count + 1);
     std::memcpy(temp, &rep->workspace[offset], count);
     temp[count] = '\0';
 
-    delete [] result.rep->workspace;
+    release_workspace(result.rep->workspace);
     result.rep->workspace = temp;
 
     return result;
@@ -1004,6 +1559,17 @@ namespace pcc {
       "HixThereyYouz" would be "There".
   */
   String String::subword(int offset, int count, const char *white) const
+  {
+    return subword(offset, count, DelimiterSet(white));
+  }
+
+
+  /*! This method is the same as subword(int, int, const char *) except
+      that the delimiters are given as a precompiled set. Callers that
+      extract many words using the same delimiters should build the set
+      once and use this method.
+  */
+  String String::subword(int offset, int count, const DelimiterSet &white) const
   {
     // Make sure I am the only one using this string's representation.
     #if defined(pMULTITHREADED)
@@ -1015,56 +1581,35 @@ namespace pcc {
 
     offset--;
 
-    if (offset < 0 || count < 0) return result;
-
-    int current_length = words(white);
-
-    // If the offset is off the end of the string, then return an empty string.
-    if (offset >= current_length) {
-      return result;
-    }
-
-    // Adjust the count if necessary.
-    if (count > current_length - offset) count = current_length - offset;
-
-    // Handle the count of zero as a special case.
-    if (count == 0) return result;
-
-    // Find the beginning of the the offsetth word.
-    const char *start = rep->workspace;
-    while (1) {
-
-      // Skip leading whitespace.
-      while (is_white(*start, white)) start++;
-
-      if (offset == 0) break;
+    if (offset < 0 || count <= 0) return result;
 
-      // Find the end of this word.
-      while (!is_white(*start, white)) start++;
+    // Find the beginning of the offsetth word. If we run off the end of
+    // the string there is no such word and the result is empty.
+    //
+    const char *start = white.skip(rep->workspace);
+    while (offset > 0 && *start) {
+      start = white.skip(white.find(start));
       offset--;
     }
+    if (*start == '\0') return result;
 
-    // Now find the end of the countth word from start.
-    const char *end = start;
-    while (1) {
-
-      // Find the end of this word.
-      while (!(is_white(*end, white) || *end == '\0')) end++;
-      count--;
-
-      if (count == 0) break;
-
-      // Find the beginning of the next word.
-      while (is_white(*end, white)) end++;
+    // Now find the end of the countth word from start, or the end of the
+    // last word if there are fewer than count words remaining.
+    //
+    const char *end = white.find(start);
+    while (--count > 0) {
+      const char *next = white.skip(end);
+      if (*next == '\0') break;
+      end = white.find(next);
     }
 
     // Now create the new character string.
     int length = static_cast<int>(end - start);
-    char *temp = new char[length + 1];
+    char *temp = allocate_workspace(length + 1);
     std::memcpy(temp, start, length);
     temp[length] = '\0';
 
-    delete [] result.rep->workspace;
+    release_workspace(result.rep->workspace);
     result.rep->workspace = temp;
 
     return result;
@@ -1078,28 +1623,29 @@ namespace pcc {
       \sa subword
   */
   int String::words(const char *white) const
+  {
+    return words(DelimiterSet(white));
+  }
+
+
+  /*! \param white The set of word delimiter characters.
+
+      \return The number of words in this string.
+  */
+  int String::words(const DelimiterSet &white) const
   {
     // Make sure I am the only one using this string's representation.
     #if defined(pMULTITHREADED)
     mutex_sem::grabber lock(string_lock);
     #endif
 
-    int  word_count = 0;   // The number of words found.
-    int  in_word    = 0;   // =1 When we are scanning a word.
-
-    // Scan down the string...
-    for (const char *p = rep->workspace; *p; p++) {
+    int word_count = 0;
 
-      // If this is the start of a word...
-      if (!is_white(*p, white) && !in_word) {
-        word_count++;
-        in_word = 1;
-      }
-
-      // If we just finished scanning a word...
-      if (is_white(*p, white) && in_word) {
-        in_word = 0;
-      }
+    // Step from the start of one word to the start of the next.
+    const char *p = white.skip(rep->workspace);
+    while (*p) {
+      word_count++;
+      p = white.skip(white.find(p));
     }
 
     return word_count;
@@ -1110,30 +1656,193 @@ namespace pcc {
       the result. Neither right nor left are modified.
   */
   String operator+(const String &left, const String &right)
-    { String temp(left); temp.append(right); return temp; }
+  {
+    StringBuilder result(left.length() + right.length());
+    result.append(left).append(right);
+    return result.finish();
+  }
 
   /*! This function concatenates right onto the end of left and returns
       the result. Neither right nor left are modified.
   */
   String operator+(const String &left, const char *right)
-    { String temp(left); temp.append(right); return temp; }
+  {
+    int right_length = std::strlen(right);
+    StringBuilder result(left.length() + right_length);
+    result.append(left).append(right, right_length);
+    return result.finish();
+  }
 
   /*! This function concatenates right onto the end of left and returns
       the result. Neither right nor left are modified.
   */
   String operator+(const char *left, const String &right)
-    { String temp(left); temp.append(right); return temp; }
+  {
+    int left_length = std::strlen(left);
+    StringBuilder result(left_length + right.length());
+    result.append(left, left_length).append(right);
+    return result.finish();
+  }
 
   /*! This function concatenates right onto the end of left and returns
       the result. Neither right nor left are modified.
   */
   String operator+(const String &left, char right)
-    { String temp(left); temp.append(right); return temp; }
+  {
+    StringBuilder result(left.length() + 1);
+    result.append(left).append(right);
+    return result.finish();
+  }
 
   /*! This function concatenates right onto the end of left and returns
       the result. Neither right nor left are modified.
   */
   String operator+(char left, const String &right)
-    { String temp(left); temp.append(right); return temp; }
+  {
+    StringBuilder result(right.length() + 1);
+    result.append(left).append(right);
+    return result.finish();
+  }
+
+
+  //-------------------------------------
+  //           Class StringBuilder
+  //-------------------------------------
+
+  /*! \param capacity The number of characters expected. The builder
+      still grows if more characters are appended.
+  */
+  StringBuilder::StringBuilder(int capacity)
+    : workspace(0), used(0), capacity(0)
+  {
+    if (capacity > 0) reserve(capacity);
+  }
+
+
+  StringBuilder::~StringBuilder()
+  {
+    if (workspace != 0) release_workspace(workspace);
+  }
+
+
+  /*! This method never shrinks the workspace. The characters already
+      appended are preserved.
+  */
+  StringBuilder &StringBuilder::reserve(int new_capacity)
+  {
+    if (new_capacity <= capacity) return *this;
+
+    char *temp = allocate_workspace(new_capacity + 1);
+    if (workspace != 0) {
+      std::memcpy(temp, workspace, used);
+      release_workspace(workspace);
+    }
+    workspace = temp;
+    capacity  = new_capacity;
+    return *this;
+  }
+
+
+  // Makes room for extra more characters. The capacity at least doubles
+  // so that a long sequence of small appends takes linear time.
+  //
+  void StringBuilder::grow(int extra)
+  {
+    if (used + extra <= capacity) return;
+
+    int new_capacity = 2 * capacity;
+    if (new_capacity < used + extra) new_capacity = used + extra;
+    if (new_capacity < 15) new_capacity = 15;
+    reserve(new_capacity);
+  }
+
+
+  StringBuilder &StringBuilder::append(const String &other)
+  {
+    #if defined(pMULTITHREADED)
+    mutex_sem::grabber lock(string_lock);
+    #endif
+
+    return append(other.rep->workspace, std::strlen(other.rep->workspace));
+  }
+
+
+  StringBuilder &StringBuilder::append(const char *other)
+  {
+    return append(other, std::strlen(other));
+  }
+
+
+  /*! The characters must not include a null character. */
+  StringBuilder &StringBuilder::append(const char *other, int count)
+  {
+    if (count <= 0) return *this;
+    grow(count);
+    std::memcpy(workspace + used, other, count);
+    used += count;
+    return *this;
+  }
+
+
+  /*! This is useful for padding. Negative counts are ignored. */
+  StringBuilder &StringBuilder::append(char ch, int count)
+  {
+    if (count <= 0) return *this;
+    grow(count);
+    std::memset(workspace + used, ch, count);
+    used += count;
+    return *this;
+  }
+
+
+  /*! \param value The integer to append.
+
+      \param width The minimum number of characters to append. If the
+      number is shorter it is right justified in a field of this width.
+
+      \param pad The character used to fill the field. If the pad
+      character is '0' a minus sign is placed before the padding.
+  */
+  StringBuilder &StringBuilder::append_number(long value, int width, char pad)
+  {
+    // Digits are generated from the right. Negate in unsigned arithmetic
+    // so that LONG_MIN is handled correctly.
+    char  buffer[3 * sizeof(long) + 1];
+    char *p = buffer + sizeof(buffer);
+    unsigned long magnitude = value < 0 ? 0UL - value : value;
+    do {
+      *--p = static_cast<char>('0' + magnitude % 10);
+      magnitude /= 10;
+    } while (magnitude != 0);
+
+    int digits  = static_cast<int>(buffer + sizeof(buffer) - p);
+    int padding = width - digits - (value < 0 ? 1 : 0);
+    if (value < 0 && pad == '0') append('-');
+    append(pad, padding);
+    if (value < 0 && pad != '0') append('-');
+    return append(p, digits);
+  }
+
+
+  /*! The workspace is given to the new String as it is. Any unused
+      capacity stays with the String until it is released, so reserve
+      accurately when building long lived strings. After this method
+      returns the builder is empty and can be reused.
+  */
+  String StringBuilder::finish()
+  {
+    // An empty builder might not have a workspace yet. Capacity does not
+    // count the null character so there is always room for it.
+    if (workspace == 0) workspace = allocate_workspace(1);
+
+    String::string_node *node = new String::string_node;
+    workspace[used] = '\0';
+    node->workspace = workspace;
+    workspace = 0;
+    used      = 0;
+    capacity  = 0;
+    return String(node);
+  }
+
 
 }
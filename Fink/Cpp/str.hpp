@@ -1,6 +1,6 @@
 /****************************************************************************
 FILE          : str.h
-LAST REVISED  : 2003-05-18
+LAST REVISED  : 2026-10-19
 SUBJECT       : Interface to a Rexx-like string class.
 PROGRAMMER    : (C) Copyright 2003 by Peter Chapin
 
@@ -10,6 +10,19 @@ the features of strings that exist in the Rexx language.
 
 REVISION HISTORY
 
++ 2026-10-19: Added StringBuilder for assembling a String from many
+  pieces with a single allocation.
+
++ 2026-10-19: Added hashing. The hash value is cached in the shared
+  representation. Added std::hash<pcc::String> and function objects for
+  unordered containers that also accept C-style strings.
+
++ 2026-10-19: String nodes and small workspaces now come from thread
+  local pools. Added allocation counters.
+
++ 2026-10-19: Added DelimiterSet so that the word oriented methods can
+  classify characters with a precompiled table.
+
 + 2003-05-18: Fixed severe bugs in the multithread handling. See str.cpp
   for more information. Added doxygen style documentation.
 
@@ -47,14 +60,60 @@ Please send comments or bug reports pertaining to this file to
 #define STR_H
 
 #include "environ.hpp"
+#include <cstddef>
+#include <cstring>
+#include <functional>
 #include <iosfwd>
 #include <limits.h>
 
 namespace pcc {
 
+  //! Precompiled set of delimiter characters.
+  /*! Objects of this class are used by the word oriented methods of
+      String. Building a set once and reusing it avoids scanning the
+      delimiter list for every character examined.
+  */
+  class DelimiterSet {
+  public:
+
+    //! Construct a set from a string of delimiter characters.
+    explicit DelimiterSet(const char *delimiters = 0);
+
+    //! Return true if ch is a member of this set.
+    bool contains(char ch) const
+    {
+      unsigned char index = static_cast<unsigned char>(ch);
+      return (table[index >> 5] >> (index & 31)) & 1U;
+    }
+
+    //! Return a pointer to the first non-delimiter at or after p.
+    const char *skip(const char *p) const;
+
+    //! Return a pointer to the first delimiter (or null) at or after p.
+    const char *find(const char *p) const;
+
+  private:
+    // One bit for each possible character value.
+    unsigned int table[8];
+
+    // Small sets are also kept as a list of members. This allows the
+    // members to be compared against a block of characters at once.
+    //
+    enum { MAX_MEMBERS = 8 };
+    char members[MAX_MEMBERS];
+    int  member_count;     // Negative if the set is too large for the list.
+
+    void add(char ch);
+  };
+
+  class StringBuilder;
+
   //! String class supporting Rexx-like operations.
   class String {
 
+    //! Builders install their finished workspace directly.
+    friend class StringBuilder;
+
     //! Insert a string into an output stream.
     friend std::ostream &operator<<(std::ostream &, const String &);
 
@@ -74,18 +133,45 @@ namespace pcc {
     // Strings share their representations when possible. Copying is
     // done on demand.
     //
+    // The hash value is computed on demand and then shared by all the
+    // Strings using the node. Mutating operations always install a new
+    // node so a cached value never describes the wrong text.
+    //
     struct string_node {
-      int   count;
-      char *workspace;
+      int          count;
+      char        *workspace;
+      bool         hashed;
+      std::size_t  hash_value;
+
+      string_node() : count(1), workspace(0), hashed(false), hash_value(0) { }
 
-      string_node() : count(1), workspace(0) { }
+      // Nodes are allocated from a pool. See str.cpp.
+      static void *operator new(std::size_t size);
+      static void  operator delete(void *p, std::size_t size);
     };
 
     string_node *rep;
 
+    // Used by StringBuilder. The new String takes ownership of node.
+    explicit String(string_node *node) : rep(node) { }
+
   public:
 
-   
+    //! Counts of the memory allocation requests made by this class.
+    /*! The counters are maintained separately for each thread. */
+    struct allocation_counters {
+      unsigned long requests;       //!< Nodes and workspaces requested.
+      unsigned long pool_hits;      //!< Requests satisfied from a pool.
+      unsigned long system_calls;   //!< Requests passed to operator new.
+      unsigned long bytes;          //!< Total bytes requested.
+    };
+
+    //! Return the allocation counters for the calling thread.
+    static allocation_counters counters();
+
+    //! Reset the allocation counters for the calling thread to zero.
+    static void reset_counters();
+
     //! Construct an empty string.
     String();
 
@@ -117,6 +203,12 @@ namespace pcc {
     //! Return the length of this string.
     int length() const;
 
+    //! Return a hash of this string's contents.
+    std::size_t hash() const;
+
+    //! Return a hash of the given characters.
+    static std::size_t hash(const char *);
+
     //! Return the length of this string.
     /*! \sa length */
     int size() const { return length(); }
@@ -164,6 +256,9 @@ namespace pcc {
     //! Strip leading or trailing instances of kill_char from this string.
     String strip(char mode = 'B', char kill_char = ' ') const;
 
+    //! Strip leading or trailing members of kill_set from this string.
+    String strip(char mode, const DelimiterSet &kill_set) const;
+
     //! Locate a substring of this string.
     String substr(int offset, int count = INT_MAX) const;
 
@@ -172,6 +267,10 @@ namespace pcc {
     String subword(
       int offset, int count = INT_MAX, const char *white = 0) const;
 
+    //! Locate a substring of this string consisting of the specified
+    //! number of words.
+    String subword(int offset, int count, const DelimiterSet &white) const;
+
     //! Return a specific word from this string.
     /*! \param offset The index of the word of interest.
 
@@ -183,8 +282,15 @@ namespace pcc {
     String word(int offset, const char *white = 0) const
       { return subword(offset, 1, white); }
 
+    //! Return a specific word from this string.
+    String word(int offset, const DelimiterSet &white) const
+      { return subword(offset, 1, white); }
+
     //! Return the number of words in this string.
     int words(const char *white = 0) const;
+
+    //! Return the number of words in this string.
+    int words(const DelimiterSet &white) const;
   };
 
   // +++++
@@ -217,6 +323,32 @@ namespace pcc {
   inline bool operator<=(const String &left, const String &right)
     { return right >= left; }
 
+  // +++++
+  // Function objects for unordered containers. These are "transparent"
+  // so containers that support heterogeneous lookup can find a String key
+  // using a C-style string without constructing a temporary String.
+  // +++++
+
+  //! Hash a String or a C-style string.
+  struct StringHash {
+    typedef void is_transparent;
+
+    std::size_t operator()(const String &s) const { return s.hash(); }
+    std::size_t operator()(const char *s) const { return String::hash(s); }
+  };
+
+  //! Compare Strings and C-style strings for equality.
+  struct StringEqual {
+    typedef void is_transparent;
+
+    bool operator()(const String &left, const String &right) const
+      { return left == right; }
+    bool operator()(const String &left, const char *right) const
+      { return std::strcmp(left, right) == 0; }
+    bool operator()(const char *left, const String &right) const
+      { return (*this)(right, left); }
+  };
+
   // +++++
   // Infix binary concatenation is too useful to pass up.
   // +++++
@@ -236,6 +368,69 @@ namespace pcc {
   //! Concatenate a character and a string.
   String operator+(char left, const String &right);
 
+  //! Efficient construction of a String from many pieces.
+  /*! A StringBuilder accumulates characters in a single workspace that
+      grows as needed. If the final length is known when the builder is
+      created, the workspace is allocated only once. The finish() method
+      gives the workspace to a new String without copying it. Building a
+      long string this way is much faster than a chain of append() or
+      operator+ calls, each of which copies everything built so far.
+  */
+  class StringBuilder {
+  public:
+
+    //! Construct an empty builder with room for capacity characters.
+    explicit StringBuilder(int capacity = 0);
+
+    //! Destroy this builder, releasing any unfinished text.
+   ~StringBuilder();
+
+    //! Make room for at least capacity characters in total.
+    StringBuilder &reserve(int capacity);
+
+    //! Return the number of characters appended so far.
+    int length() const { return used; }
+
+    //! Append the given string.
+    StringBuilder &append(const String &);
+
+    //! Append the given string.
+    StringBuilder &append(const char *);
+
+    //! Append the first count characters of the given string.
+    StringBuilder &append(const char *, int count);
+
+    //! Append count copies of the given character.
+    StringBuilder &append(char, int count = 1);
+
+    //! Append the decimal representation of an integer.
+    StringBuilder &append_number(long value, int width = 0, char pad = ' ');
+
+    //! Return the text as a String and make this builder empty.
+    String finish();
+
+  private:
+    char *workspace;     // Null until space is first needed.
+    int   used;
+    int   capacity;      // Does not include room for the null character.
+
+    void grow(int extra);
+
+    // Copying is not supported.
+    StringBuilder(const StringBuilder &);
+    StringBuilder &operator=(const StringBuilder &);
+  };
+
+}
+
+namespace std {
+
+  //! Allow Strings to be used as keys in the standard unordered containers.
+  template<>
+  struct hash<pcc::String> {
+    std::size_t operator()(const pcc::String &s) const { return s.hash(); }
+  };
+
 }
 
 #endif
@@ -0,0 +1,549 @@
+/****************************************************************************
+FILE      : strbench.cpp
+SUBJECT   : Benchmarks for the pcc::String class.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+This program times the operations of pcc::String and compares them with
+the equivalent operations of std::string. For each case it reports the
+average time per operation, the number of calls to the global operator
+new per operation, and the number of bytes requested from operator new
+per operation. For pcc::String it also reports the number of requests
+made to the String memory pools per operation.
+
+The program should be built twice: once normally and once with the
+symbol pMULTITHREADED defined. See the Makefile (targets strbench and
+strbench-mt). The concurrent cases show the cost of the string lock.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "linereader.hpp"
+#include "str.hpp"
+
+using namespace std;
+
+//+++++++++++++++++++++++++++++++++
+//           Global Data
+//+++++++++++++++++++++++++++++++++
+
+// Results are accumulated here so the compiler can't discard the work.
+static long sink = 0;
+
+// Counts of the calls made to the global operator new by each thread.
+static thread_local unsigned long new_calls = 0;
+static thread_local unsigned long new_bytes = 0;
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++
+//           Global Allocation Functions
+//+++++++++++++++++++++++++++++++++++++++++++++++++
+
+// These replace the library versions so the allocations made by both string classes can be
+// counted. The array forms are replaced too so the set is consistent. All of the deletes free
+// the memory in one function that isn't inlined, so the compiler doesn't pair the free with
+// the library's operator new and warn about a mismatch.
+
+__attribute__((noinline)) static void release_memory(void *p)
+{
+    free(p);
+}
+
+void *operator new(size_t size)
+{
+    new_calls++;
+    new_bytes += size;
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == 0) throw bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    release_memory(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    release_memory(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    release_memory(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    release_memory(p);
+}
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++
+//           Internally Linked Functions
+//+++++++++++++++++++++++++++++++++++++++++++++++++
+
+//
+// time_case
+//
+// Runs the given operation the given number of times and reports the average time, the
+// average number of operator new calls, and the average number of bytes allocated per
+// operation. If pooled is true, the String pool requests per operation are also reported.
+//
+template<typename Operation>
+static void time_case(const char *name, long iterations, bool pooled, Operation operation)
+{
+    unsigned long calls_before = new_calls;
+    unsigned long bytes_before = new_bytes;
+    pcc::String::reset_counters();
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        sink += operation();
+    }
+    chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+
+    double elapsed = chrono::duration<double, nano>(stop - start).count();
+    double calls   = double(new_calls - calls_before) / iterations;
+    double bytes   = double(new_bytes - bytes_before) / iterations;
+    printf("%-36s %12.1f %10.2f %12.1f", name, elapsed / iterations, calls, bytes);
+    if (pooled) {
+        printf(" %10.2f", double(pcc::String::counters().requests) / iterations);
+    }
+    printf("\n");
+}
+
+//
+// time_concurrent
+//
+// Runs the given operation in the given number of threads at once. Each thread performs the
+// operation the given number of times and passes its own number (0 up to thread_count - 1) and
+// the iteration to the operation. Reports the average wall clock time per operation over all
+// threads.
+//
+template<typename Operation>
+static void time_concurrent(
+    const char *name, int thread_count, long iterations, Operation operation)
+{
+    vector<thread> threads;
+    vector<long>   results(thread_count, 0);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int t = 0; t < thread_count; ++t) {
+        threads.push_back(thread([&, t] {
+            long local = 0;
+            for (long i = 0; i < iterations; ++i) {
+                local += operation(t, i);
+            }
+            results[t] = local;
+        }));
+    }
+    for (int t = 0; t < thread_count; ++t) {
+        threads[t].join();
+        sink += results[t];
+    }
+    chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+
+    double elapsed = chrono::duration<double, nano>(stop - start).count();
+    printf("%-36s %12.1f   (%d threads)\n", name, elapsed / (iterations * thread_count),
+           thread_count);
+}
+
+//
+// heading
+//
+static void heading(const char *title)
+{
+    printf("\n--- %s ---\n", title);
+    printf("%-36s %12s %10s %12s %10s\n", "case", "ns/op", "allocs/op", "bytes/op", "pool/op");
+}
+
+//
+// make_text
+//
+// Returns a string of the given length made from a repeating pattern of words. The pattern
+// does not contain the character 'Z' so searches for it scan the entire string.
+//
+static string make_text(size_t length)
+{
+    static const char pattern[] = "the quick brown fox jumps over the lazy dog ";
+    string result;
+    result.reserve(length);
+    while (result.length() < length) {
+        result += pattern[result.length() % (sizeof(pattern) - 1)];
+    }
+    return result;
+}
+
+//
+// std_subword
+//
+// Returns count words of text starting with word number offset (one based). This mimics
+// pcc::String::subword with the default delimiters.
+//
+static string std_subword(const string &text, int offset, int count)
+{
+    static const char white[] = " \t\v\r\n\f";
+    size_t start = text.find_first_not_of(white);
+    while (--offset > 0 && start != string::npos) {
+        start = text.find_first_not_of(white, text.find_first_of(white, start));
+    }
+    if (start == string::npos) return string();
+
+    size_t end = text.find_first_of(white, start);
+    while (--count > 0 && end != string::npos) {
+        size_t next = text.find_first_not_of(white, end);
+        if (next == string::npos) break;
+        end = text.find_first_of(white, next);
+    }
+    return text.substr(start, end == string::npos ? string::npos : end - start);
+}
+
+//
+// std_strip
+//
+// Removes leading and trailing spaces. This mimics pcc::String::strip.
+//
+static string std_strip(const string &text)
+{
+    size_t start = text.find_first_not_of(' ');
+    if (start == string::npos) return string();
+    size_t end = text.find_last_not_of(' ');
+    return text.substr(start, end - start + 1);
+}
+
+//
+// std_center
+//
+// Centers text in a field of the given width. This mimics pcc::String::center.
+//
+static string std_center(const string &text, size_t width)
+{
+    if (width <= text.length()) return text.substr(0, width);
+    size_t left_side = (width - text.length()) / 2;
+    string result;
+    result.reserve(width);
+    result.append(left_side, ' ');
+    result.append(text);
+    result.append(width - text.length() - left_side, ' ');
+    return result;
+}
+
+//
+// construction_benchmarks
+//
+static void construction_benchmarks()
+{
+    const char *short_text = "hello world";
+    string      long_source = make_text(200);
+    const char *long_text = long_source.c_str();
+
+    pcc::String pcc_short(short_text);
+    pcc::String pcc_long(long_text);
+    string      std_short(short_text);
+    string      std_long(long_text);
+
+    heading("construction and copying");
+
+    time_case("String(const char *) short", 2000000L, true,
+              [&] { pcc::String s(short_text); return s.length(); });
+    time_case("std::string(const char *) short", 2000000L, false,
+              [&] { string s(short_text); return (long)s.length(); });
+    time_case("String(const char *) long", 1000000L, true,
+              [&] { pcc::String s(long_text); return s.length(); });
+    time_case("std::string(const char *) long", 1000000L, false,
+              [&] { string s(long_text); return (long)s.length(); });
+    time_case("String copy long", 2000000L, true,
+              [&] { pcc::String s(pcc_long); return (long)(s == pcc_long); });
+    time_case("std::string copy long", 2000000L, false,
+              [&] { string s(std_long); return (long)(s == std_long); });
+}
+
+//
+// append_benchmarks
+//
+// Builds a string of the given length one character at a time.
+//
+static void append_benchmarks(int length)
+{
+    char title[64];
+    sprintf(title, "append loops (%d characters)", length);
+    heading(title);
+
+    time_case("String::append(char) loop", 20000L, true, [&] {
+        pcc::String s;
+        for (int i = 0; i < length; ++i) s.append('x');
+        return s.length();
+    });
+    time_case("std::string::append(char) loop", 20000L, false, [&] {
+        string s;
+        for (int i = 0; i < length; ++i) s.append(1, 'x');
+        return (long)s.length();
+    });
+    time_case("StringBuilder::append(char) loop", 20000L, true, [&] {
+        pcc::StringBuilder builder;
+        for (int i = 0; i < length; ++i) builder.append('x');
+        return builder.finish().length();
+    });
+    time_case("String operator+ chain", 200000L, true, [&] {
+        pcc::String s = pcc::String("alpha") + ", " + "beta" + ", " + "gamma" + '!';
+        return s.length();
+    });
+    time_case("std::string operator+ chain", 200000L, false, [&] {
+        string s = string("alpha") + ", " + "beta" + ", " + "gamma" + '!';
+        return (long)s.length();
+    });
+    time_case("StringBuilder chain", 200000L, true, [&] {
+        pcc::StringBuilder builder(20);
+        builder.append("alpha").append(", ").append("beta").append(", ").append("gamma");
+        return builder.append('!').finish().length();
+    });
+}
+
+//
+// substring_benchmarks
+//
+static void substring_benchmarks()
+{
+    string      std_text = make_text(200);
+    pcc::String pcc_text(std_text.c_str());
+    string      std_padded = "        " + std_text.substr(0, 40) + "        ";
+    pcc::String pcc_padded(std_padded.c_str());
+
+    heading("substrings, words, and padding");
+
+    time_case("String::substr", 1000000L, true,
+              [&] { return pcc_text.substr(20, 30).length(); });
+    time_case("std::string::substr", 1000000L, false,
+              [&] { return (long)std_text.substr(19, 30).length(); });
+    time_case("String::word", 1000000L, true,
+              [&] { return pcc_text.word(7).length(); });
+    time_case("std::string word", 1000000L, false,
+              [&] { return (long)std_subword(std_text, 7, 1).length(); });
+    time_case("String::subword", 1000000L, true,
+              [&] { return pcc_text.subword(3, 5).length(); });
+    time_case("std::string subword", 1000000L, false,
+              [&] { return (long)std_subword(std_text, 3, 5).length(); });
+    time_case("String::words", 1000000L, true,
+              [&] { return (long)pcc_text.words(); });
+    time_case("String::strip", 1000000L, true,
+              [&] { return pcc_padded.strip().length(); });
+    time_case("std::string strip", 1000000L, false,
+              [&] { return (long)std_strip(std_padded).length(); });
+    time_case("String::center", 1000000L, true,
+              [&] { return pcc_padded.center(80).length(); });
+    time_case("std::string center", 1000000L, false,
+              [&] { return (long)std_center(std_padded, 80).length(); });
+    time_case("String::copy", 1000000L, true,
+              [&] { return pcc_padded.copy(4).length(); });
+}
+
+//
+// search_benchmarks
+//
+// Compares String::pos and String::last_pos with std::string::find and std::string::rfind.
+//
+static void search_benchmarks(const char *label, size_t length, long iterations)
+{
+    string       std_text = make_text(length);
+    pcc::String  pcc_text(std_text.c_str());
+
+    // A long needle that almost matches everywhere exercises the worst case.
+    string       std_worst(length, 'a');
+    pcc::String  pcc_worst(std_worst.c_str());
+    string       worst_needle(40, 'a');
+    worst_needle += 'b';
+
+    const char  *short_needle = "lazy cat";
+    const char  *long_needle  = "jumps over the lazy dog the quick brown cat";
+    char         title[64];
+
+    sprintf(title, "search, %s haystack (%lu characters)", label, (unsigned long)length);
+    heading(title);
+
+    time_case("String::pos(char)", iterations, true,
+              [&] { return pcc_text.pos('Z'); });
+    time_case("std::string::find(char)", iterations, false,
+              [&] { return (long)std_text.find('Z'); });
+    time_case("String::last_pos(char)", iterations, true,
+              [&] { return pcc_text.last_pos('Z'); });
+    time_case("std::string::rfind(char)", iterations, false,
+              [&] { return (long)std_text.rfind('Z'); });
+    time_case("String::pos(short needle)", iterations, true,
+              [&] { return pcc_text.pos(short_needle); });
+    time_case("std::string::find(short needle)", iterations, false,
+              [&] { return (long)std_text.find(short_needle); });
+    time_case("String::pos(long needle)", iterations, true,
+              [&] { return pcc_text.pos(long_needle); });
+    time_case("std::string::find(long needle)", iterations, false,
+              [&] { return (long)std_text.find(long_needle); });
+    time_case("String::pos(worst case)", iterations, true,
+              [&] { return pcc_worst.pos(worst_needle.c_str()); });
+    time_case("std::string::find(worst case)", iterations, false,
+              [&] { return (long)std_worst.find(worst_needle); });
+}
+
+//
+// input_benchmarks
+//
+// Reads a block of text one line at a time. Each operation is one line. LineReader reads a
+// file so the text is also written to a temporary file for it.
+//
+static void input_benchmarks(size_t line_length)
+{
+    const int line_count = 1000;
+    string    line = make_text(line_length);
+    string    text;
+    for (int i = 0; i < line_count; ++i) {
+        text += line;
+        text += '\n';
+    }
+
+    char title[64];
+    sprintf(title, "line input (%lu characters per line)", (unsigned long)line_length);
+    heading(title);
+
+    // The stream is rebuilt once per pass, so each pass reads line_count lines.
+    istringstream pcc_input(text);
+    pcc::String   pcc_line;
+    long          pcc_lines = 0;
+    time_case("operator>>(istream &, String &)", 100L * line_count, true, [&] {
+        if (++pcc_lines % line_count == 1) { pcc_input.clear(); pcc_input.str(text); }
+        pcc_input >> pcc_line;
+        return pcc_line.length();
+    });
+
+    const char *file_name = "strbench.tmp";
+    FILE       *file      = fopen(file_name, "wb");
+    if (file == 0 || fwrite(text.data(), 1, text.size(), file) != text.size()) {
+        printf("%-36s (can't write %s)\n", "LineReader::next", file_name);
+    }
+    else {
+        fclose(file);
+        file = 0;
+        unique_ptr<pcc::LineReader> reader;
+        long reader_lines = 0;
+        time_case("LineReader::next", 100L * line_count, false, [&] {
+            if (++reader_lines % line_count == 1) reader.reset(new pcc::LineReader(file_name));
+            const char *line;
+            int         length = 0;
+            reader->next(line, length);
+            return (long)length;
+        });
+        reader.reset();
+    }
+    if (file != 0) fclose(file);
+    remove(file_name);
+
+    istringstream std_input(text);
+    string        std_line;
+    long          std_lines = 0;
+    time_case("getline(istream &, std::string &)", 100L * line_count, false, [&] {
+        if (++std_lines % line_count == 1) { std_input.clear(); std_input.str(text); }
+        getline(std_input, std_line);
+        return (long)std_line.length();
+    });
+}
+
+//
+// concurrent_benchmarks
+//
+// Several threads read a shared table of strings. With pMULTITHREADED defined every String
+// operation takes the global string lock so these cases measure contention on that lock.
+//
+// Copying a String and hashing it change the representation it shares with the original.
+// Without pMULTITHREADED that is only safe if no other thread uses the original, so those
+// cases copy from a private table for each thread. The shared table is only copied from when
+// the lock is there to protect it.
+//
+static void concurrent_benchmarks(int thread_count)
+{
+    const int table_size = 64;
+    vector<pcc::String>          pcc_table;
+    vector<vector<pcc::String> > private_tables(thread_count);
+    vector<string>               std_table;
+    for (int i = 0; i < table_size; ++i) {
+        string text = make_text(40 + i);
+        pcc_table.push_back(pcc::String(text.c_str()));
+        for (int t = 0; t < thread_count; ++t) {
+            private_tables[t].push_back(pcc::String(text.c_str()));
+        }
+        std_table.push_back(text);
+    }
+
+    printf("\n--- concurrent reads ---\n");
+
+    time_concurrent("String length/pos/compare", thread_count, 200000L, [&](int, long i) {
+        const pcc::String &s = pcc_table[i % table_size];
+        return s.length() + s.pos("lazy") + (s < pcc_table[(i + 1) % table_size]);
+    });
+    time_concurrent("std::string length/find/compare", thread_count, 200000L,
+                    [&](int, long i) {
+        const string &s = std_table[i % table_size];
+        return (long)(s.length() + s.find("lazy") + (s < std_table[(i + 1) % table_size]));
+    });
+    time_concurrent("String copy and hash (own table)", thread_count, 200000L,
+                    [&](int t, long i) {
+        pcc::String s(private_tables[t][i % table_size]);
+        return (long)s.hash();
+    });
+    #if defined(pMULTITHREADED)
+    time_concurrent("String copy and hash (shared table)", thread_count, 200000L,
+                    [&](int, long i) {
+        pcc::String s(pcc_table[i % table_size]);
+        return (long)s.hash();
+    });
+    #endif
+    time_concurrent("std::string copy and hash", thread_count, 200000L, [&](int, long i) {
+        string s(std_table[i % table_size]);
+        return (long)hash<string>()(s);
+    });
+}
+
+//++++++++++++++++++++++++++++++++++++++
+//           Public Functions
+//++++++++++++++++++++++++++++++++++++++
+
+//
+// main
+//
+int main()
+{
+    #if defined(pMULTITHREADED)
+    printf("pcc::String benchmarks (pMULTITHREADED defined)\n");
+    #else
+    printf("pcc::String benchmarks (pMULTITHREADED not defined)\n");
+    #endif
+
+    construction_benchmarks();
+    append_benchmarks(100);
+    substring_benchmarks();
+    search_benchmarks("short", 64, 2000000L);
+    search_benchmarks("long", 1024 * 1024, 200L);
+    input_benchmarks(40);
+    input_benchmarks(2000);
+
+    unsigned thread_count = thread::hardware_concurrency();
+    concurrent_benchmarks(thread_count < 2 ? 2 : (thread_count > 8 ? 8 : thread_count));
+
+    // Print the sink so the work above is observable.
+    printf("\n(checksum %ld)\n", sink);
+    return 0;
+}
@@ -3,6 +3,14 @@ FILE      : uints.cpp
 SUBJECT   : Implementation of various unsigned integer types.
 PROGRAMMER: (C) Copyright 2003 by Peter Chapin
 
+The range checked constructors and the array kernels are here. Everything
+else is inline in uints.hpp.
+
+The multi-precision kernels combine the 16 or 32 bit limbs of the caller
+into 64 bit limbs and propagate the carry (or borrow) from one 64 bit limb
+to the next. With gcc the carry is computed with __builtin_add_overflow()
+so it comes straight from the processor's carry flag.
+
 Please send comments or bug reports to
 
      Peter Chapin
@@ -11,192 +19,250 @@ Please send comments or bug reports to
      PChapin@vtc.vsc.edu
 ****************************************************************************/
 
+#include "environ.hpp"
 #include "uints.hpp"
 
 //
-// Here are the various friend functions. Since they all have the same format, I put them all
-// together.
+// class Byte
 //
 
-Byte operator+(const Byte &Left, const Byte &Right)
-{
-    Byte Temp(Left);
-    Temp += Right;
-    return Temp;
-}
-
-Byte operator-(const Byte &Left, const Byte &Right)
-{
-    Byte Temp(Left);
-    Temp -= Right;
-    return Temp;
-}
-
-Word operator+(const Word &Left, const Word &Right)
+Byte::Byte(long Initial)
 {
-    Word Temp(Left);
-    Temp += Right;
-    return Temp;
-}
+    if (Initial < -128L || Initial > 255L)
+        throw uint_Error(uint_Error::RANGE_ERROR, uint_Error::BYTE);
 
-Word operator-(const Word &Left, const Word &Right)
-{
-    Word Temp(Left);
-    Temp -= Right;
-    return Temp;
+    Number = (std::uint8_t)Initial;
 }
 
-DoubleWord operator+(const DoubleWord &Left, const DoubleWord &Right)
-{
-    DoubleWord Temp(Left);
-    Temp += Right;
-    return Temp;
-}
 
-DoubleWord operator-(const DoubleWord &Left, const DoubleWord &Right)
-{
-    DoubleWord Temp(Left);
-    Temp -= Right;
-    return Temp;
-}
+//
+// class Word
+//
 
-QuadWord operator+(const QuadWord &Left, const QuadWord &Right)
+Word::Word(long Initial)
 {
-    QuadWord Temp(Left);
-    Temp += Right;
-    return Temp;
-}
+    if (Initial < -32768L || Initial > 65535L)
+        throw uint_Error(uint_Error::RANGE_ERROR, uint_Error::WORD);
 
-QuadWord operator-(const QuadWord &Left, const QuadWord &Right)
-{
-    QuadWord Temp(Left);
-    Temp -= Right;
-    return Temp;
+    Number = (std::uint16_t)Initial;
 }
 
 
 //
-// class Byte
+// class DoubleWord
 //
 
-Byte::Byte(long Initial)
+DoubleWord::DoubleWord(long Initial)
 {
-    if (Initial < -128L || Initial > 255L) 
-        throw uint_Error(uint_Error::RANGE_ERROR, uint_Error::BYTE);
+    // This test can only fail on systems where long is wider than 32 bits.
+    if ((long long)Initial < -2147483648LL || (long long)Initial > 4294967295LL)
+        throw uint_Error(uint_Error::RANGE_ERROR, uint_Error::DOUBLEWORD);
 
-    Number = (unsigned char)Initial;
+    Number = (std::uint32_t)Initial;
 }
 
-Byte::operator long()
-{
-    return (long)Number;
-}
 
-void Byte::operator+=(const Byte &Other)
-{
-    Number += Other.Number;
-}
+//
+// class QuadWord
+//
 
-void Byte::operator-=(const Byte &Other)
+QuadWord::QuadWord(long Initial)
 {
-    Number -= Other.Number;
+    // Anything coming through in 'Initial' will fit. Negative values are sign extended.
+    Number = (std::uint64_t)(std::int64_t)Initial;
 }
 
 
 //
-// class Word
+// Array kernels
 //
 
-Word::Word(long Initial)
-{
-    if (Initial < -32768L || Initial > 65535L) 
-        throw uint_Error(uint_Error::RANGE_ERROR, uint_Error::WORD);
+namespace uint_Detail {
+
+    // Adds Left, Right, and Carry (zero or one). Returns the carry out.
+    static inline unsigned add_with_carry(std::uint64_t Left, std::uint64_t Right, unsigned Carry, std::uint64_t &Sum)
+    {
+        #if eCOMPILER == eGCC
+        std::uint64_t Temp;
+        bool Carry1 = __builtin_add_overflow(Left, Right, &Temp);
+        bool Carry2 = __builtin_add_overflow(Temp, (std::uint64_t)Carry, &Sum);
+        return Carry1 | Carry2;
+        #else
+        std::uint64_t Temp = Left + Right;
+        unsigned Carry1 = Temp < Left;
+        Sum = Temp + Carry;
+        return Carry1 | (Sum < Temp);
+        #endif
+    }
 
-    Number = (unsigned int)Initial;
-}
+    // Subtracts Right and Borrow (zero or one) from Left. Returns the borrow out.
+    static inline unsigned sub_with_borrow(std::uint64_t Left, std::uint64_t Right, unsigned Borrow, std::uint64_t &Difference)
+    {
+        #if eCOMPILER == eGCC
+        std::uint64_t Temp;
+        bool Borrow1 = __builtin_sub_overflow(Left, Right, &Temp);
+        bool Borrow2 = __builtin_sub_overflow(Temp, (std::uint64_t)Borrow, &Difference);
+        return Borrow1 | Borrow2;
+        #else
+        std::uint64_t Temp = Left - Right;
+        unsigned Borrow1 = Left < Right;
+        Difference = Temp - Borrow;
+        return Borrow1 | (Temp < Borrow);
+        #endif
+    }
 
-Word::operator long()
-{
-    return (long)Number;
+    struct Kernels {
+
+        // Packs the limbs Limbs[0] .. Limbs[PER - 1] into a 64 bit value, least significant first.
+        template<typename U>
+        static std::uint64_t pack(const U *Limbs)
+        {
+            const int PER  = 8 / sizeof(Limbs->Number);
+            const int BITS = 8 * sizeof(Limbs->Number);
+
+            std::uint64_t Value = 0;
+            for (int j = PER - 1; j >= 0; --j) {
+                Value = (Value << BITS) | Limbs[j].Number;
+            }
+            return Value;
+        }
+
+        template<typename U>
+        static void unpack(U *Limbs, std::uint64_t Value)
+        {
+            const int PER  = 8 / sizeof(Limbs->Number);
+            const int BITS = 8 * sizeof(Limbs->Number);
+
+            for (int j = 0; j < PER; ++j) {
+                Limbs[j].Number = static_cast<decltype(Limbs->Number)>(Value);
+                Value >>= BITS;
+            }
+        }
+
+        template<typename U>
+        static uint_Error::Status add(U *Result, const U *Left, const U *Right, std::size_t Count)
+        {
+            const std::size_t PER  = 8 / sizeof(Left->Number);
+            const int         BITS = 8 * sizeof(Left->Number);
+
+            unsigned    Carry = 0;
+            std::size_t i = 0;
+            for ( ; i + PER <= Count; i += PER) {
+                std::uint64_t Sum;
+                Carry = add_with_carry(pack(Left + i), pack(Right + i), Carry, Sum);
+                unpack(Result + i, Sum);
+            }
+
+            // Remaining limbs are done one at a time.
+            for ( ; i < Count; ++i) {
+                std::uint64_t Sum = (std::uint64_t)Left[i].Number + Right[i].Number + Carry;
+                Result[i].Number = static_cast<decltype(Result->Number)>(Sum);
+                Carry = static_cast<unsigned>(Sum >> BITS);
+            }
+            return Carry ? uint_Error::CARRY : uint_Error::SUCCESS;
+        }
+
+        template<typename U>
+        static uint_Error::Status sub(U *Result, const U *Left, const U *Right, std::size_t Count)
+        {
+            const std::size_t PER  = 8 / sizeof(Left->Number);
+            const int         BITS = 8 * sizeof(Left->Number);
+
+            unsigned    Borrow = 0;
+            std::size_t i = 0;
+            for ( ; i + PER <= Count; i += PER) {
+                std::uint64_t Difference;
+                Borrow = sub_with_borrow(pack(Left + i), pack(Right + i), Borrow, Difference);
+                unpack(Result + i, Difference);
+            }
+
+            // Remaining limbs are done one at a time. The borrow shows up as the low bit of the
+            // part of the difference above the limb.
+            for ( ; i < Count; ++i) {
+                std::uint64_t Difference = (std::uint64_t)Left[i].Number - Right[i].Number - Borrow;
+                Result[i].Number = static_cast<decltype(Result->Number)>(Difference);
+                Borrow = static_cast<unsigned>(Difference >> BITS) & 1U;
+            }
+            return Borrow ? uint_Error::BORROW : uint_Error::SUCCESS;
+        }
+
+        // The work is done in blocks of a fixed size. The inner loops have a constant trip count
+        // and no dependencies between iterations (Result may be the same as Left or Right but
+        // must not otherwise overlap them) so gcc vectorizes them even at -O2.
+        //
+        static const std::size_t BLOCK = 16;
+
+        template<typename U>
+        static void add_each(U *Result, const U *Left, const U *Right, std::size_t Count)
+        {
+            std::size_t i = 0;
+            for ( ; i + BLOCK <= Count; i += BLOCK) {
+                decltype(Result->Number) Sum[BLOCK];
+                for (std::size_t j = 0; j < BLOCK; ++j) {
+                    Sum[j] = static_cast<decltype(Result->Number)>(Left[i + j].Number + Right[i + j].Number);
+                }
+                for (std::size_t j = 0; j < BLOCK; ++j) Result[i + j].Number = Sum[j];
+            }
+            for ( ; i < Count; ++i) {
+                Result[i].Number = static_cast<decltype(Result->Number)>(Left[i].Number + Right[i].Number);
+            }
+        }
+
+        template<typename U>
+        static void add_each(U *Result, const U *Left, const U &Offset, std::size_t Count)
+        {
+            const auto  Value = Offset.Number;
+            std::size_t i = 0;
+            for ( ; i + BLOCK <= Count; i += BLOCK) {
+                decltype(Result->Number) Sum[BLOCK];
+                for (std::size_t j = 0; j < BLOCK; ++j) {
+                    Sum[j] = static_cast<decltype(Result->Number)>(Left[i + j].Number + Value);
+                }
+                for (std::size_t j = 0; j < BLOCK; ++j) Result[i + j].Number = Sum[j];
+            }
+            for ( ; i < Count; ++i) {
+                Result[i].Number = static_cast<decltype(Result->Number)>(Left[i].Number + Value);
+            }
+        }
+    };
 }
 
-void Word::operator+=(const Word &Other)
+uint_Error::Status add_multi(Word *Result, const Word *Left, const Word *Right, std::size_t Count) noexcept
 {
-    Number += Other.Number;
+    return uint_Detail::Kernels::add(Result, Left, Right, Count);
 }
 
-void Word::operator-=(const Word &Other)
+uint_Error::Status sub_multi(Word *Result, const Word *Left, const Word *Right, std::size_t Count) noexcept
 {
-    Number -= Other.Number;
+    return uint_Detail::Kernels::sub(Result, Left, Right, Count);
 }
 
-
-//
-// class DoubleWord
-//
-
-DoubleWord::DoubleWord(long Initial)
+uint_Error::Status add_multi(DoubleWord *Result, const DoubleWord *Left, const DoubleWord *Right, std::size_t Count) noexcept
 {
-    // Anything coming through in 'Initial' will fit.
-    Number = (unsigned long)Initial;
+    return uint_Detail::Kernels::add(Result, Left, Right, Count);
 }
 
-DoubleWord::operator long()
+uint_Error::Status sub_multi(DoubleWord *Result, const DoubleWord *Left, const DoubleWord *Right, std::size_t Count) noexcept
 {
-    return (long)Number;
+    return uint_Detail::Kernels::sub(Result, Left, Right, Count);
 }
 
-void DoubleWord::operator+=(const DoubleWord &Other)
+void add_each(Word *Result, const Word *Left, const Word *Right, std::size_t Count) noexcept
 {
-    Number += Other.Number;
+    uint_Detail::Kernels::add_each(Result, Left, Right, Count);
 }
 
-void DoubleWord::operator-=(const DoubleWord &Other)
+void add_each(Word *Result, const Word *Left, const Word &Offset, std::size_t Count) noexcept
 {
-    Number -= Other.Number;
+    uint_Detail::Kernels::add_each(Result, Left, Offset, Count);
 }
 
-
-//
-// class QuadWord
-//
-
-QuadWord::QuadWord(long Initial)
-{
-    // Anything coming through in 'Initial' will fit.
-    Number[0] = (unsigned)  (0x0000FFFFUL & (unsigned long)Initial);
-    Number[1] = (unsigned) ((0xFFFF0000UL & (unsigned long)Initial) >> 16);
-
-    // We should sign extend negative values.
-    if (Initial < 0) {
-        Number[2] = 0xFFFFU;
-        Number[3] = 0xFFFFU;
-    }
-    else {
-        Number[2] = 0x0000U;
-        Number[3] = 0x0000U;
-    }
-}
-
-void QuadWord::operator+=(const QuadWord &Other)
+void add_each(DoubleWord *Result, const DoubleWord *Left, const DoubleWord *Right, std::size_t Count) noexcept
 {
-    long Carry = 0;
-
-    for (int i = 0; i < 4; i++) {
-        long Sum  = Number[i] + Other.Number[i] + Carry;
-        Number[i] = (unsigned) (0x0000FFFFUL & Sum);
-        Carry     = (0xFFFF0000UL & Sum) >> 16;
-    }
+    uint_Detail::Kernels::add_each(Result, Left, Right, Count);
 }
 
-void QuadWord::operator-=(const QuadWord &Other)
+void add_each(DoubleWord *Result, const DoubleWord *Left, const DoubleWord &Offset, std::size_t Count) noexcept
 {
-    long Borrow = 0;
-
-    for (int i = 0; i < 4; i++) {
-        long Difference = Number[i] - Other.Number[i] - Borrow;
-        Number[i] = (unsigned) (0x0000FFFFUL & Difference);
-        Borrow    = (0xFFFF0000L  & Difference) >> 16;
-    }
+    uint_Detail::Kernels::add_each(Result, Left, Offset, Count);
 }
-
@@ -3,6 +3,21 @@ FILE      : uints.hpp
 SUBJECT   : Unsigned integer classes
 PROGRAMMER: (C) Copyright 2003 by Peter Chapin
 
+The constructors taking a long check their argument and throw uint_Error
+if it is out of range. When the caller has already validated a value (or
+wants modular behavior) the constructors taking a uint_Unchecked tag can
+be used instead. They never throw and simply keep the low order bits.
+
+The arithmetic operators wrap around. Each class also has saturating
+and checked versions of addition and subtraction. The checked versions
+report a carry or borrow with a status code instead of an exception.
+Everything except the checked constructors is inline (and constexpr) so
+that address arithmetic compiles to single machine instructions.
+
+The functions add_multi() and sub_multi() treat arrays of Words or
+DoubleWords as the limbs of arbitrarily large numbers. The functions
+add_each() perform many independent additions at once.
+
 Please send comments or bug reports to
 
      Peter Chapin
@@ -14,6 +29,9 @@ Please send comments or bug reports to
 #ifndef UINTS_H
 #define UINTS_H
 
+#include <cstddef>
+#include <cstdint>
+
 //
 // This error class is used by all the classes below. This is because they all have similar
 // error needs.
@@ -23,86 +41,231 @@ public:
     enum Error_Mode { RANGE_ERROR };
     enum Size       { BYTE, WORD, DOUBLEWORD, QUADWORD };
 
+    // Returned by the checked arithmetic functions.
+    enum Status     { SUCCESS, CARRY, BORROW };
+
     Error_Mode What;
     Size       Who;
 
     uint_Error(Error_Mode X, Size  Y) : What(X), Who(Y) { }
 };
 
+//
+// Tag type used to select the unchecked constructors. For example: Word(Address, Unchecked).
+//
+struct uint_Unchecked { };
+constexpr uint_Unchecked Unchecked = uint_Unchecked();
+
+//
+// Helpers used by all the classes below. T is the (unsigned) representation type.
+//
+namespace uint_Detail {
+
+    // Implements the array functions declared at the end of this file. See uints.cpp.
+    struct Kernels;
+
+    template<typename T>
+    constexpr T saturating_add(T Left, T Right) noexcept
+    {
+        return static_cast<T>(Left + Right) < Left ? static_cast<T>(~T(0)) : static_cast<T>(Left + Right);
+    }
+
+    template<typename T>
+    constexpr T saturating_sub(T Left, T Right) noexcept
+    {
+        return Right > Left ? T(0) : static_cast<T>(Left - Right);
+    }
+
+    template<typename T>
+    constexpr uint_Error::Status checked_add(T Left, T Right, T &Result) noexcept
+    {
+        Result = static_cast<T>(Left + Right);
+        return Result < Left ? uint_Error::CARRY : uint_Error::SUCCESS;
+    }
+
+    template<typename T>
+    constexpr uint_Error::Status checked_sub(T Left, T Right, T &Result) noexcept
+    {
+        Result = static_cast<T>(Left - Right);
+        return Right > Left ? uint_Error::BORROW : uint_Error::SUCCESS;
+    }
+}
+
 
 //
 // 8 bit unsigned integers.
 //
 class Byte {
 private:
-    unsigned char Number;
+    std::uint8_t Number;
 
 public:
-    Byte(long Initial = 0L);
-    operator long();
+    constexpr Byte() noexcept : Number(0) { }
+    Byte(long Initial);
+    constexpr Byte(long Initial, uint_Unchecked) noexcept
+        : Number(static_cast<std::uint8_t>(Initial)) { }
+
+    constexpr operator long() const noexcept { return static_cast<long>(Number); }
+
+    constexpr void operator+=(const Byte &Other) noexcept { Number += Other.Number; }
+    constexpr void operator-=(const Byte &Other) noexcept { Number -= Other.Number; }
 
-    void operator+=(const Byte &);
-    void operator-=(const Byte &);
+    friend constexpr Byte saturating_add(const Byte &Left, const Byte &Right) noexcept
+        { return Byte(uint_Detail::saturating_add(Left.Number, Right.Number), Unchecked); }
+    friend constexpr Byte saturating_sub(const Byte &Left, const Byte &Right) noexcept
+        { return Byte(uint_Detail::saturating_sub(Left.Number, Right.Number), Unchecked); }
+    friend constexpr uint_Error::Status checked_add(const Byte &Left, const Byte &Right, Byte &Result) noexcept
+        { return uint_Detail::checked_add(Left.Number, Right.Number, Result.Number); }
+    friend constexpr uint_Error::Status checked_sub(const Byte &Left, const Byte &Right, Byte &Result) noexcept
+        { return uint_Detail::checked_sub(Left.Number, Right.Number, Result.Number); }
 };
 
-Byte operator+(const Byte &, const Byte &);
-Byte operator-(const Byte &, const Byte &);
+constexpr Byte operator+(const Byte &Left, const Byte &Right) noexcept
+    { Byte Temp(Left); Temp += Right; return Temp; }
+constexpr Byte operator-(const Byte &Left, const Byte &Right) noexcept
+    { Byte Temp(Left); Temp -= Right; return Temp; }
+constexpr Byte wrapping_add(const Byte &Left, const Byte &Right) noexcept
+    { return Left + Right; }
+constexpr Byte wrapping_sub(const Byte &Left, const Byte &Right) noexcept
+    { return Left - Right; }
 
 
 //
 // 16 bit unsigned integers.
 //
 class Word {
+    friend struct uint_Detail::Kernels;
+
 private:
-    unsigned short Number;
+    std::uint16_t Number;
 
 public:
-    Word(long Initial = 0L);
-    operator long();
+    constexpr Word() noexcept : Number(0) { }
+    Word(long Initial);
+    constexpr Word(long Initial, uint_Unchecked) noexcept
+        : Number(static_cast<std::uint16_t>(Initial)) { }
+
+    constexpr operator long() const noexcept { return static_cast<long>(Number); }
+
+    constexpr void operator+=(const Word &Other) noexcept { Number += Other.Number; }
+    constexpr void operator-=(const Word &Other) noexcept { Number -= Other.Number; }
 
-    void operator+=(const Word &);
-    void operator-=(const Word &);
+    friend constexpr Word saturating_add(const Word &Left, const Word &Right) noexcept
+        { return Word(uint_Detail::saturating_add(Left.Number, Right.Number), Unchecked); }
+    friend constexpr Word saturating_sub(const Word &Left, const Word &Right) noexcept
+        { return Word(uint_Detail::saturating_sub(Left.Number, Right.Number), Unchecked); }
+    friend constexpr uint_Error::Status checked_add(const Word &Left, const Word &Right, Word &Result) noexcept
+        { return uint_Detail::checked_add(Left.Number, Right.Number, Result.Number); }
+    friend constexpr uint_Error::Status checked_sub(const Word &Left, const Word &Right, Word &Result) noexcept
+        { return uint_Detail::checked_sub(Left.Number, Right.Number, Result.Number); }
 };
 
-Word operator+(const Word &, const Word &);
-Word operator-(const Word &, const Word &);
+constexpr Word operator+(const Word &Left, const Word &Right) noexcept
+    { Word Temp(Left); Temp += Right; return Temp; }
+constexpr Word operator-(const Word &Left, const Word &Right) noexcept
+    { Word Temp(Left); Temp -= Right; return Temp; }
+constexpr Word wrapping_add(const Word &Left, const Word &Right) noexcept
+    { return Left + Right; }
+constexpr Word wrapping_sub(const Word &Left, const Word &Right) noexcept
+    { return Left - Right; }
 
 
 //
 // 32 bit unsigned integers.
 //
 class DoubleWord {
+    friend struct uint_Detail::Kernels;
+
 private:
-    unsigned long Number;
+    std::uint32_t Number;
 
 public:
-    DoubleWord(long Initial = 0L);
-    operator long();
+    constexpr DoubleWord() noexcept : Number(0) { }
+    DoubleWord(long Initial);
+    constexpr DoubleWord(long Initial, uint_Unchecked) noexcept
+        : Number(static_cast<std::uint32_t>(Initial)) { }
+
+    constexpr operator long() const noexcept { return static_cast<long>(Number); }
 
-    void operator+=(const DoubleWord &);
-    void operator-=(const DoubleWord &);
+    constexpr void operator+=(const DoubleWord &Other) noexcept { Number += Other.Number; }
+    constexpr void operator-=(const DoubleWord &Other) noexcept { Number -= Other.Number; }
+
+    friend constexpr DoubleWord saturating_add(const DoubleWord &Left, const DoubleWord &Right) noexcept
+        { return DoubleWord(uint_Detail::saturating_add(Left.Number, Right.Number), Unchecked); }
+    friend constexpr DoubleWord saturating_sub(const DoubleWord &Left, const DoubleWord &Right) noexcept
+        { return DoubleWord(uint_Detail::saturating_sub(Left.Number, Right.Number), Unchecked); }
+    friend constexpr uint_Error::Status checked_add(const DoubleWord &Left, const DoubleWord &Right, DoubleWord &Result) noexcept
+        { return uint_Detail::checked_add(Left.Number, Right.Number, Result.Number); }
+    friend constexpr uint_Error::Status checked_sub(const DoubleWord &Left, const DoubleWord &Right, DoubleWord &Result) noexcept
+        { return uint_Detail::checked_sub(Left.Number, Right.Number, Result.Number); }
 };
 
-DoubleWord operator+(const DoubleWord &, const DoubleWord &);
-DoubleWord operator-(const DoubleWord &, const DoubleWord &);
+constexpr DoubleWord operator+(const DoubleWord &Left, const DoubleWord &Right) noexcept
+    { DoubleWord Temp(Left); Temp += Right; return Temp; }
+constexpr DoubleWord operator-(const DoubleWord &Left, const DoubleWord &Right) noexcept
+    { DoubleWord Temp(Left); Temp -= Right; return Temp; }
+constexpr DoubleWord wrapping_add(const DoubleWord &Left, const DoubleWord &Right) noexcept
+    { return Left + Right; }
+constexpr DoubleWord wrapping_sub(const DoubleWord &Left, const DoubleWord &Right) noexcept
+    { return Left - Right; }
+
 
 //
-// 64 bit unsigned integers.
+// 64 bit unsigned integers. The conversion to long reinterprets the bits on hosts where long
+// is 64 bits and keeps only the low order 32 bits elsewhere.
 //
 class QuadWord {
 private:
-    unsigned int Number[4];
+    std::uint64_t Number;
 
 public:
-    QuadWord(long Initial = 0L);
-    operator long();
+    constexpr QuadWord() noexcept : Number(0) { }
+    QuadWord(long Initial);
+    constexpr QuadWord(long Initial, uint_Unchecked) noexcept
+        : Number(static_cast<std::uint64_t>(static_cast<std::int64_t>(Initial))) { }
+
+    constexpr operator long() const noexcept { return static_cast<long>(Number); }
+
+    constexpr void operator+=(const QuadWord &Other) noexcept { Number += Other.Number; }
+    constexpr void operator-=(const QuadWord &Other) noexcept { Number -= Other.Number; }
 
-    void operator+=(const QuadWord &);
-    void operator-=(const QuadWord &);
+    friend constexpr QuadWord saturating_add(const QuadWord &Left, const QuadWord &Right) noexcept
+        { QuadWord Temp; Temp.Number = uint_Detail::saturating_add(Left.Number, Right.Number); return Temp; }
+    friend constexpr QuadWord saturating_sub(const QuadWord &Left, const QuadWord &Right) noexcept
+        { QuadWord Temp; Temp.Number = uint_Detail::saturating_sub(Left.Number, Right.Number); return Temp; }
+    friend constexpr uint_Error::Status checked_add(const QuadWord &Left, const QuadWord &Right, QuadWord &Result) noexcept
+        { return uint_Detail::checked_add(Left.Number, Right.Number, Result.Number); }
+    friend constexpr uint_Error::Status checked_sub(const QuadWord &Left, const QuadWord &Right, QuadWord &Result) noexcept
+        { return uint_Detail::checked_sub(Left.Number, Right.Number, Result.Number); }
 };
 
-QuadWord operator+(const QuadWord &, const QuadWord &);
-QuadWord operator-(const QuadWord &, const QuadWord &);
+constexpr QuadWord operator+(const QuadWord &Left, const QuadWord &Right) noexcept
+    { QuadWord Temp(Left); Temp += Right; return Temp; }
+constexpr QuadWord operator-(const QuadWord &Left, const QuadWord &Right) noexcept
+    { QuadWord Temp(Left); Temp -= Right; return Temp; }
+constexpr QuadWord wrapping_add(const QuadWord &Left, const QuadWord &Right) noexcept
+    { return Left + Right; }
+constexpr QuadWord wrapping_sub(const QuadWord &Left, const QuadWord &Right) noexcept
+    { return Left - Right; }
 
-#endif
 
+//
+// Multi-precision arithmetic. Each array holds the limbs of one number with the least
+// significant limb first. Result may be the same array as Left or Right but must not otherwise
+// overlap them. The return value is CARRY (or BORROW) if the result does not fit in Count limbs.
+//
+uint_Error::Status add_multi(Word *Result, const Word *Left, const Word *Right, std::size_t Count) noexcept;
+uint_Error::Status sub_multi(Word *Result, const Word *Left, const Word *Right, std::size_t Count) noexcept;
+uint_Error::Status add_multi(DoubleWord *Result, const DoubleWord *Left, const DoubleWord *Right, std::size_t Count) noexcept;
+uint_Error::Status sub_multi(DoubleWord *Result, const DoubleWord *Left, const DoubleWord *Right, std::size_t Count) noexcept;
+
+//
+// Independent wrapping additions: Result[i] = Left[i] + Right[i] (or Left[i] + Offset) for each
+// i less than Count. These loops are simple enough for the compiler to vectorize.
+//
+void add_each(Word *Result, const Word *Left, const Word *Right, std::size_t Count) noexcept;
+void add_each(Word *Result, const Word *Left, const Word &Offset, std::size_t Count) noexcept;
+void add_each(DoubleWord *Result, const DoubleWord *Left, const DoubleWord *Right, std::size_t Count) noexcept;
+void add_each(DoubleWord *Result, const DoubleWord *Left, const DoubleWord &Offset, std::size_t Count) noexcept;
+
+#endif
@@ -0,0 +1,90 @@
+/****************************************************************************
+FILE      : arena.cpp
+SUBJECT   : Implementation of a simple region allocator.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "arena.h"
+#include <cstring>
+#include <new>
+
+thread_local arena *node_arena = 0;
+
+// Every allocation is rounded up to a multiple of this.
+static const std::size_t alignment = alignof(std::max_align_t);
+
+static std::size_t round_up(std::size_t size)
+{
+  return (size + alignment - 1) & ~(alignment - 1);
+}
+
+// The block header is padded so that the storage after it is aligned.
+static const std::size_t header_size = round_up(sizeof(void *));
+
+
+arena::arena(std::size_t size)
+  : blocks(0), next_free(0), limit(0), block_size(size), total(0)
+{ }
+
+
+void *arena::allocate(std::size_t size)
+{
+  size = round_up(size == 0 ? 1 : size);
+  total += size;
+
+  if (static_cast<std::size_t>(limit - next_free) < size) {
+
+    // Large requests get a block of their own so the current block isn't wasted.
+    if (size > block_size / 4) {
+      return allocate_block(size);
+    }
+    char *storage = static_cast<char *>(allocate_block(block_size));
+    next_free = storage;
+    limit     = storage + block_size;
+  }
+
+  void *result = next_free;
+  next_free += size;
+  return result;
+}
+
+
+// Allocates a new block with room for size bytes and returns a pointer to that room. The list
+// of blocks is only used by release(); the current block is tracked by next_free and limit.
+//
+void *arena::allocate_block(std::size_t size)
+{
+  block *new_block = static_cast<block *>(::operator new(header_size + size));
+  new_block->next = blocks;
+  blocks = new_block;
+  return reinterpret_cast<char *>(new_block) + header_size;
+}
+
+
+const char *arena::copy_string(const char *text, std::size_t length)
+{
+  char *copy = static_cast<char *>(allocate(length + 1));
+  std::memcpy(copy, text, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+
+void arena::release()
+{
+  while (blocks != 0) {
+    block *next = blocks->next;
+    ::operator delete(blocks);
+    blocks = next;
+  }
+  next_free = 0;
+  limit     = 0;
+  total     = 0;
+}
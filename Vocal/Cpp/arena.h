@@ -0,0 +1,64 @@
+/****************************************************************************
+FILE      : arena.h
+SUBJECT   : Declaration of a simple region allocator.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+An arena hands out memory from large blocks and releases all of it at
+once. The compiler allocates its syntax tree nodes this way so that
+building the tree is cheap and tearing it down requires no traversal.
+Objects allocated in an arena are never destroyed. They must not own
+resources (such as std::string members) that need a destructor.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+
+class arena {
+public:
+  explicit arena(std::size_t block_size = 64 * 1024);
+  ~arena() { release(); }
+
+  // Returns storage for an object of the given size. The storage is suitably aligned for any
+  // type. It remains valid until release() is called.
+  void *allocate(std::size_t size);
+
+  // Copies a string into the arena and returns the null terminated copy.
+  const char *copy_string(const char *text, std::size_t length);
+
+  // Frees every block at once. The arena can be used again afterward.
+  void release();
+
+  // Returns the number of bytes handed out since the last release.
+  std::size_t bytes_allocated() const { return total; }
+
+private:
+  struct block {
+    block *next;
+  };
+
+  block       *blocks;       // Most recently allocated block first.
+  char        *next_free;    // Next free byte in the current block.
+  char        *limit;        // One past the end of the current block.
+  std::size_t  block_size;
+  std::size_t  total;
+
+  void *allocate_block(std::size_t size);
+
+  // Copying is not supported.
+  arena(const arena &);
+  arena &operator=(const arena &);
+};
+
+// The arena used for the syntax tree of the function being compiled. Each thread has its own.
+extern thread_local arena *node_arena;
+
+#endif
@@ -0,0 +1,134 @@
+/****************************************************************************
+FILE      : code-buffer.cpp
+SUBJECT   : Implementation of the buffer that collects generated assembly.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "code-buffer.h"
+
+// Labels are numbered separately for each function, which may be compiled on any thread.
+static thread_local int labelnum = 0;
+
+label next_label()
+{
+  return label(labelnum++);
+}
+
+
+int reset_labels()
+{
+  int count = labelnum;
+  labelnum = 0;
+  return count;
+}
+
+
+code_buffer::code_buffer()
+  : file(0), buffer(new char[chunk_size]), next_free(buffer), written(0), failed(false)
+{ }
+
+
+code_buffer::~code_buffer()
+{
+  if (file != 0) close();
+  delete [] buffer;
+}
+
+
+bool code_buffer::open(const char *filename)
+{
+  next_free = buffer;
+  written   = 0;
+  failed    = false;
+  file = std::fopen(filename, "wb");
+  return file != 0;
+}
+
+
+bool code_buffer::close()
+{
+  flush();
+  if (file != 0) {
+    if (std::fclose(file) != 0) failed = true;
+    file = 0;
+  }
+  return !failed;
+}
+
+
+// Writes the buffered text to the file. A failed write is remembered and reported by close().
+void code_buffer::flush()
+{
+  std::size_t count = next_free - buffer;
+  if (count != 0 && file != 0) {
+    if (std::fwrite(buffer, 1, count, file) != count) failed = true;
+  }
+  written  += count;
+  next_free = buffer;
+}
+
+
+void code_buffer::append(const char *text, std::size_t length)
+{
+  if (length > chunk_size) {
+    // Too big to buffer. Write it directly after anything already waiting.
+    flush();
+    if (file != 0 && std::fwrite(text, 1, length, file) != length) failed = true;
+    written += length;
+    return;
+  }
+  reserve(length);
+  std::memcpy(next_free, text, length);
+  next_free += length;
+}
+
+
+// Formats a decimal integer directly into the buffer.
+void code_buffer::append_number(long value)
+{
+  char  digits[24];
+  char *p = digits + sizeof(digits);
+
+  // Work with the magnitude as unsigned so that the most negative value is handled.
+  unsigned long magnitude = value < 0 ? 0UL - static_cast<unsigned long>(value) : value;
+  do {
+    *--p = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) *--p = '-';
+
+  std::size_t length = digits + sizeof(digits) - p;
+  reserve(length);
+  std::memcpy(next_free, p, length);
+  next_free += length;
+}
+
+
+// Formats a label as _L followed by its number in at least six digits.
+void code_buffer::append_label(label l)
+{
+  char  digits[16];
+  char *p = digits + sizeof(digits);
+
+  unsigned number = static_cast<unsigned>(l.number);
+  int      count  = 0;
+  do {
+    *--p = static_cast<char>('0' + number % 10);
+    number /= 10;
+    ++count;
+  } while (number != 0 || count < 6);
+  *--p = 'L';
+  *--p = '_';
+
+  std::size_t length = digits + sizeof(digits) - p;
+  reserve(length);
+  std::memcpy(next_free, p, length);
+  next_free += length;
+}
@@ -0,0 +1,98 @@
+/****************************************************************************
+FILE      : code-buffer.h
+SUBJECT   : Declaration of the buffer that collects generated assembly.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+The code generator appends its output to a code_buffer rather than to a
+stream. The text accumulates in memory and is written to the output file
+in large chunks, so generating a line costs a few byte copies instead of
+a formatted stream insertion and a flush. Integers and labels are
+formatted directly into the buffer.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef CODE_BUFFER_H
+#define CODE_BUFFER_H
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// A label in the generated code. Labels are numbered; the text form is _Lnnnnnn.
+struct label {
+  int number;
+
+  label() : number(-1) { }
+  explicit label(int n) : number(n) { }
+};
+
+// Returns a new label every time. Labels are numbered from zero on each thread.
+label next_label();
+
+// Starts numbering labels from zero again. Returns the number of labels used since the last
+// reset.
+//
+int reset_labels();
+
+class code_buffer {
+public:
+  code_buffer();
+  ~code_buffer();
+
+  // Opens the output file. Returns false if it can't be opened.
+  bool open(const char *filename);
+
+  // Writes whatever is buffered and closes the file. Returns false if any write failed.
+  bool close();
+
+  code_buffer &operator<<(const char *text)
+    { append(text, std::strlen(text)); return *this; }
+  code_buffer &operator<<(const std::string &text)
+    { append(text.data(), text.length()); return *this; }
+  code_buffer &operator<<(char ch)
+    { reserve(1); *next_free++ = ch; return *this; }
+  code_buffer &operator<<(int value)
+    { append_number(value); return *this; }
+  code_buffer &operator<<(long value)
+    { append_number(value); return *this; }
+  code_buffer &operator<<(label l)
+    { append_label(l); return *this; }
+
+  // Appends text that need not be null terminated.
+  code_buffer &write(const char *text, std::size_t length)
+    { append(text, length); return *this; }
+
+  // Returns the number of bytes generated so far, including those already written.
+  std::size_t bytes_generated() const { return written + (next_free - buffer); }
+
+private:
+  // The buffer is written to the file whenever this much text has accumulated.
+  static const std::size_t chunk_size = 1024 * 1024;
+
+  std::FILE   *file;
+  char        *buffer;
+  char        *next_free;
+  std::size_t  written;
+  bool         failed;
+
+  void reserve(std::size_t count)
+    { if (static_cast<std::size_t>(next_free - buffer) + count > chunk_size) flush(); }
+
+  void append(const char *text, std::size_t length);
+  void append_number(long value);
+  void append_label(label l);
+  void flush();
+
+  // Copying is not supported.
+  code_buffer(const code_buffer &);
+  code_buffer &operator=(const code_buffer &);
+};
+
+#endif
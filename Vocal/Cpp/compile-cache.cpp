@@ -0,0 +1,131 @@
+/****************************************************************************
+FILE      : compile-cache.cpp
+SUBJECT   : Implementation of the cache of compiled files.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "compile-cache.h"
+#include "code-buffer.h"
+#include "source-file.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//
+// Class hasher
+//
+
+// The FNV parameters for 128 bit hashes.
+static const unsigned __int128 fnv_offset_basis =
+  (static_cast<unsigned __int128>(0x6c62272e07bb0142ULL) << 64) | 0x62b821756295c58dULL;
+static const unsigned __int128 fnv_prime =
+  (static_cast<unsigned __int128>(0x0000000001000000ULL) << 64) | 0x000000000000013bULL;
+
+hasher::hasher()
+  : state(fnv_offset_basis)
+{ }
+
+
+void hasher::add(const char *data, std::size_t size)
+{
+  unsigned __int128 hash = state;
+  for (std::size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= fnv_prime;
+  }
+  state = hash;
+}
+
+
+// Strings are added with their lengths so that the boundary between two of them is part of the
+// hash ("ab" + "c" differs from "a" + "bc").
+//
+void hasher::add(const std::string &text)
+{
+  std::string length = std::to_string(text.length()) + ':';
+  add(length.data(), length.length());
+  add(text.data(), text.length());
+}
+
+
+std::string hasher::digest() const
+{
+  static const char hex[] = "0123456789abcdef";
+  std::string result(32, '0');
+  unsigned __int128 hash = state;
+  for (int i = 31; i >= 0; --i) {
+    result[i] = hex[static_cast<unsigned>(hash & 0xF)];
+    hash >>= 4;
+  }
+  return result;
+}
+
+//
+// Class compile_cache
+//
+
+// Copies one file to another. Returns false if anything goes wrong.
+static bool copy_file(const std::string &from, const std::string &to)
+{
+  source_file input;
+  if (!input.open(from.c_str())) return false;
+
+  code_buffer output;
+  if (!output.open(to.c_str())) return false;
+  output.write(input.text(), input.size());
+  return output.close();
+}
+
+
+bool compile_cache::open(
+  const std::string &cache_directory, const std::string &identity, const std::string &options)
+{
+  if (mkdir(cache_directory.c_str(), 0777) != 0 && errno != EEXIST) return false;
+  struct stat status;
+  if (stat(cache_directory.c_str(), &status) != 0 || !S_ISDIR(status.st_mode)) return false;
+
+  directory = cache_directory;
+  prefix    = hasher();
+  prefix.add(identity);
+  prefix.add(options);
+  enabled   = true;
+  return true;
+}
+
+
+std::string compile_cache::key(const char *source, std::size_t size) const
+{
+  hasher hash(prefix);
+  hash.add(source, size);
+  return hash.digest();
+}
+
+
+bool compile_cache::fetch(const std::string &key, const std::string &output_name) const
+{
+  return copy_file(directory + "/" + key, output_name);
+}
+
+
+void compile_cache::store(const std::string &key, const std::string &output_name) const
+{
+  // Write the entry under a name no one else is using, then rename it into place.
+  static std::atomic<unsigned> serial_number(0);
+  std::string entry = directory + "/" + key;
+  std::string temporary = entry + "." + std::to_string(getpid()) + "." +
+    std::to_string(serial_number++) + ".tmp";
+
+  if (!copy_file(output_name, temporary) || std::rename(temporary.c_str(), entry.c_str()) != 0) {
+    std::remove(temporary.c_str());
+  }
+}
@@ -0,0 +1,81 @@
+/****************************************************************************
+FILE      : compile-cache.h
+SUBJECT   : Declaration of the cache of compiled files.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+The compiler can keep a copy of each output file it writes in a cache
+directory. The copy is filed under a hash of everything the output
+depends on: the compiler itself, the options that affect code generation,
+and the bytes of the source file. When the same source is compiled again
+the cached output is copied into place and the file is not parsed or
+compiled at all.
+
+The cache is only an optimization. If an entry can't be read or written
+the file is simply compiled.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include <cstddef>
+#include <string>
+
+// A 128 bit FNV-1a hash. Bytes can be added a piece at a time.
+class hasher {
+public:
+  hasher();
+
+  void add(const char *data, std::size_t size);
+  void add(const std::string &text);
+
+  // Returns the hash as 32 hexadecimal digits.
+  std::string digest() const;
+
+private:
+  unsigned __int128 state;
+};
+
+class compile_cache {
+public:
+  compile_cache() : enabled(false) { }
+
+  // Starts using the given directory, creating it if necessary. The identity distinguishes one
+  // build of the compiler from another and the options are those that change the generated
+  // code. Returns false if the directory can't be used.
+  //
+  bool open(const std::string &directory, const std::string &identity, const std::string &options);
+
+  // Returns true if open() succeeded.
+  bool active() const { return enabled; }
+
+  // Returns the key of the output produced from the given source text.
+  std::string key(const char *source, std::size_t size) const;
+
+  // Copies the cached output with the given key to the named file. Returns false if there is no
+  // such entry or it can't be copied.
+  //
+  bool fetch(const std::string &key, const std::string &output_name) const;
+
+  // Copies the named file into the cache under the given key. Several threads (or several
+  // compilers) may store entries at once; each entry appears all at once or not at all.
+  //
+  void store(const std::string &key, const std::string &output_name) const;
+
+private:
+  bool        enabled;
+  std::string directory;
+  hasher      prefix;   // The identity and options, which are the same for every key.
+
+  // Copying is not supported.
+  compile_cache(const compile_cache &);
+  compile_cache &operator=(const compile_cache &);
+};
+
+#endif
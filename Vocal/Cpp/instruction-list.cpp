@@ -0,0 +1,217 @@
+/****************************************************************************
+FILE      : instruction-list.cpp
+SUBJECT   : Implementation of the structured form of generated code.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "instruction-list.h"
+#include <cstring>
+
+thread_local instruction_list *code = 0;
+
+static const struct {
+  const char *name;
+  int operands;
+} operations[] = {
+  { "nop",  0 }, { "copy", 2 }, { "add",  2 }, { "sub",  2 }, { "cmp",  2 },
+  { "and",  2 }, { "or",   2 }, { "xor",  2 }, { "inc",  1 }, { "dec",  1 },
+  { "shl",  1 }, { "shr",  1 }, { "rtl",  1 }, { "rtr",  1 }, { "call", 1 },
+  { "ret",  0 }, { "reti", 0 }, { "push", 1 }, { "pop",  1 }, { "jmp",  1 },
+  { "jz",   1 }, { "jnz",  1 }, { "jc",   1 }, { "jnc",  1 }, { "stc",  0 },
+  { "clc",  0 }, { "ei",   0 }, { "di",   0 }, { "halt", 0 },
+  { "",     1 },     // LABEL
+  { "",     0 }      // DELETED
+};
+
+const char *mnemonic(opcode op)
+{
+  return operations[op].name;
+}
+
+int operand_count(opcode op)
+{
+  return operations[op].operands;
+}
+
+
+//
+// Operands
+//
+
+bool machine_operand::operator==(const machine_operand &other) const
+{
+  if (mode != other.mode || kind != other.kind) return false;
+  if (kind == VARIABLE) return std::strcmp(name, other.name) == 0;
+  return number == other.number;
+}
+
+static machine_operand make_operand(machine_operand::mode_type mode,
+                                    machine_operand::value_type kind,
+                                    int number,
+                                    const char *name)
+{
+  machine_operand op = { mode, kind, number, name };
+  return op;
+}
+
+machine_operand no_operand()
+{
+  return make_operand(machine_operand::NONE, machine_operand::NUMBER, 0, 0);
+}
+
+machine_operand immediate(int value)
+{
+  return make_operand(machine_operand::IMMEDIATE, machine_operand::NUMBER, value, 0);
+}
+
+machine_operand reg(int number)
+{
+  return make_operand(machine_operand::REGISTER, machine_operand::NUMBER, number, 0);
+}
+
+machine_operand reg_indirect(int number)
+{
+  return make_operand(machine_operand::REGISTER_INDIRECT, machine_operand::NUMBER, number, 0);
+}
+
+machine_operand address_of(const char *variable)
+{
+  return make_operand(machine_operand::IMMEDIATE, machine_operand::VARIABLE, 0, variable);
+}
+
+machine_operand contents_of(const char *variable)
+{
+  return make_operand(machine_operand::INDIRECT, machine_operand::VARIABLE, 0, variable);
+}
+
+machine_operand address_of(label target)
+{
+  return make_operand(machine_operand::IMMEDIATE, machine_operand::LABEL, target.number, 0);
+}
+
+
+//
+// Class instruction_list
+//
+
+int instruction::size() const
+{
+  if (op == LABEL || op == DELETED) return 0;
+  return 1 + first.size() + second.size();
+}
+
+// Returns the five bit addressing mode and register field of an operand.
+static unsigned operand_field(const machine_operand &op)
+{
+  switch (op.mode) {
+  case machine_operand::REGISTER:
+    return (1U << 3) | static_cast<unsigned>(op.number);
+  case machine_operand::INDIRECT:
+    return 2U << 3;
+  case machine_operand::REGISTER_INDIRECT:
+    return (3U << 3) | static_cast<unsigned>(op.number);
+  default:
+    return 0;  // Immediate.
+  }
+}
+
+// The operation is in bits 10-14, the source field in bits 5-9, and the destination field in
+// bits 0-4. The single operand of inc, dec, the shifts, the rotates, and pop is a destination;
+// that of the other one operand instructions is a source.
+//
+unsigned instruction::encoding() const
+{
+  unsigned word = static_cast<unsigned>(op) << 10;
+  switch (operand_count(op)) {
+  case 2:
+    word |= (operand_field(first) << 5) | operand_field(second);
+    break;
+  case 1:
+    if ((op >= INC && op <= RTR) || op == POP) word |= operand_field(first);
+    else word |= operand_field(first) << 5;
+    break;
+  }
+  return word;
+}
+
+int instruction_list::instruction_count() const
+{
+  int count = 0;
+  for (std::vector<instruction>::const_iterator p = code.begin(); p != code.end(); ++p) {
+    if (p->op != LABEL && p->op != DELETED) ++count;
+  }
+  return count;
+}
+
+// Where a function's code goes in the output file.
+struct placement {
+  int         label_base;
+  const char *prefix;
+};
+
+static void write_value(code_buffer &out, const machine_operand &op, const placement &where)
+{
+  switch (op.kind) {
+  case machine_operand::NUMBER:
+    out << op.number;
+    break;
+  case machine_operand::VARIABLE:
+    out << '_' << where.prefix << op.name;
+    break;
+  case machine_operand::LABEL:
+    out << label(where.label_base + op.number);
+    break;
+  }
+}
+
+static void write_operand(code_buffer &out, const machine_operand &op, const placement &where)
+{
+  switch (op.mode) {
+  case machine_operand::NONE:
+    break;
+  case machine_operand::IMMEDIATE:
+    write_value(out, op, where);
+    break;
+  case machine_operand::REGISTER:
+    out << 'r' << op.number;
+    break;
+  case machine_operand::INDIRECT:
+    out << '(';
+    write_value(out, op, where);
+    out << ')';
+    break;
+  case machine_operand::REGISTER_INDIRECT:
+    out << "(r" << op.number << ')';
+    break;
+  }
+}
+
+void instruction_list::write(code_buffer &out, int label_base, const char *prefix) const
+{
+  placement where = { label_base, prefix };
+  for (std::vector<instruction>::const_iterator p = code.begin(); p != code.end(); ++p) {
+    if (p->op == DELETED) continue;
+    if (p->op == LABEL) {
+      write_value(out, p->first, where);
+      out << ":" << '\n';
+      continue;
+    }
+    out << "    " << mnemonic(p->op);
+    if (p->first.mode != machine_operand::NONE) {
+      out << ' ';
+      write_operand(out, p->first, where);
+    }
+    if (p->second.mode != machine_operand::NONE) {
+      out << ", ";
+      write_operand(out, p->second, where);
+    }
+    out << '\n';
+  }
+}
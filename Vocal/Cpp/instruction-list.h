@@ -0,0 +1,118 @@
+/****************************************************************************
+FILE      : instruction-list.h
+SUBJECT   : Declaration of the structured form of generated code.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+The code generator appends instructions to an instruction_list rather
+than writing assembly text directly. This lets later passes (such as the
+peephole optimizer) examine and rewrite the code before it is written to
+the output file.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef INSTRUCTION_LIST_H
+#define INSTRUCTION_LIST_H
+
+#include <vector>
+#include "code-buffer.h"
+
+// The VuPP operations. LABEL marks the definition of a label and DELETED marks an instruction
+// that has been removed but not yet compacted out of the list.
+//
+enum opcode {
+  NOP, COPY, ADD, SUB, CMP, AND, OR, XOR, INC, DEC, SHL, SHR, RTL, RTR,
+  CALL, RET, RETI, PUSH, POP, JMP, JZ, JNZ, JC, JNC, STC, CLC, EI, DI, HALT,
+  LABEL, DELETED
+};
+
+// Returns the mnemonic of an operation.
+const char *mnemonic(opcode op);
+
+// Returns the number of operands an operation takes.
+int operand_count(opcode op);
+
+// An instruction operand. The value is a number, the address of a variable, or the address of
+// a label. The addressing mode says how the instruction uses it.
+//
+struct machine_operand {
+  enum mode_type { NONE, IMMEDIATE, REGISTER, INDIRECT, REGISTER_INDIRECT };
+  enum value_type { NUMBER, VARIABLE, LABEL };
+
+  mode_type   mode;
+  value_type  kind;
+  int         number;  // Constant, register, or label number.
+  const char *name;    // Variable name, without the leading underscore.
+
+  bool operator==(const machine_operand &other) const;
+  bool operator!=(const machine_operand &other) const { return !(*this == other); }
+
+  // Returns the size of the operand in words (immediate and indirect operands take a word
+  // after the instruction).
+  int size() const { return (mode == IMMEDIATE || mode == INDIRECT) ? 1 : 0; }
+};
+
+machine_operand no_operand();
+machine_operand immediate(int value);
+machine_operand reg(int number);
+machine_operand reg_indirect(int number);
+machine_operand address_of(const char *variable);   // _x
+machine_operand contents_of(const char *variable);  // (_x)
+machine_operand address_of(label target);           // _Lnnnnnn
+
+struct instruction {
+  opcode          op;
+  machine_operand first;   // The source of a two operand instruction.
+  machine_operand second;  // The destination of a two operand instruction.
+
+  // Returns the size of the instruction in words.
+  int size() const;
+
+  // Returns the first word of the instruction's machine code (see www/iset.xhtml). Any
+  // immediate or indirect operands follow it, first operand first.
+  //
+  unsigned encoding() const;
+};
+
+class instruction_list {
+public:
+  void emit(opcode op)
+    { append(op, no_operand(), no_operand()); }
+  void emit(opcode op, const machine_operand &a)
+    { append(op, a, no_operand()); }
+  void emit(opcode op, const machine_operand &a, const machine_operand &b)
+    { append(op, a, b); }
+  void define(label l)
+    { append(LABEL, address_of(l), no_operand()); }
+
+  std::vector<instruction> &instructions() { return code; }
+  const std::vector<instruction> &instructions() const { return code; }
+
+  // Returns the number of instructions, not counting labels.
+  int instruction_count() const;
+
+  // Writes the instructions as assembly language. When several functions share an output file
+  // their labels and variables must be kept apart: label_base is added to every label number
+  // and prefix is put in front of every variable name.
+  //
+  void write(code_buffer &out, int label_base = 0, const char *prefix = "") const;
+
+private:
+  std::vector<instruction> code;
+
+  void append(opcode op, const machine_operand &a, const machine_operand &b)
+  {
+    instruction i = { op, a, b };
+    code.push_back(i);
+  }
+};
+
+// The code of the function being compiled. Each thread has its own.
+extern thread_local instruction_list *code;
+
+#endif
@@ -0,0 +1,1237 @@
+/****************************************************************************
+FILE      : instruction-selection.cpp
+SUBJECT   : Implementation of the instruction selector.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "instruction-list.h"
+#include "instruction-selection.h"
+#include "value-stack.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// One word of a value. Constants and int variables are used directly as instruction operands.
+// Temporaries are kept in entries on the value stack, which live in registers.
+//
+struct operand {
+  enum kind_type { ENTRY, IMMEDIATE, VARIABLE };
+
+  kind_type   kind;
+  int         number;  // Value stack entry or constant.
+  const char *name;    // Variable name, without the leading underscore.
+
+  static operand entry(int index)
+    { operand op = { ENTRY, index, 0 }; return op; }
+  static operand immediate(int n)
+    { operand op = { IMMEDIATE, n, 0 }; return op; }
+  static operand variable(const char *n)
+    { operand op = { VARIABLE, 0, n }; return op; }
+};
+
+// Where a value is. The high word is only used for longs. A shared value is used again later,
+// so the entries holding it must not be changed or released.
+//
+struct location {
+  symbol_type type;
+  operand     low, high;
+  bool        shared;
+
+  location() :
+    type(tERROR), low(operand::immediate(0)), high(operand::immediate(0)), shared(false) { }
+};
+
+// Where a temporary is used. Blocks are identified by their place in a preorder walk of the
+// extended blocks (see below) and the terminator of a block comes after its instructions.
+//
+struct use {
+  int order;
+  int position;
+
+  bool operator<(const use &other) const
+    { return order != other.order ? order < other.order : position < other.position; }
+};
+
+// A temporary that is used more than once or outside of the block computing it. Its entries are
+// held on the value stack. If registers are needed for something else it is stored into a
+// variable of its own (its home) and used from there. A global value is used in a block its
+// register can't reach, so it is stored into its home as soon as it is computed.
+//
+struct held_value {
+  vector<use>  uses;      // In order.
+  int          block;     // The block computing the temporary.
+  bool         global;
+  bool         active;    // True if the value can be used on the path being translated.
+  const char  *home[2];   // The names of the variables holding the LSW and MSW.
+};
+
+// What is known at the end of a block that the blocks in its extended block start with.
+struct path_state {
+  value_stack      values;
+  vector<int>      active;
+  vector<location> where;
+  int              waiting;   // The number of successors that haven't started yet.
+};
+
+// The intermediate values of the function being translated. Several functions may be translated
+// at once, so these are kept per thread.
+//
+static thread_local value_stack values;
+static thread_local vector<location> temporaries;   // Indexed by temporary number.
+static thread_local vector<label> block_labels;     // Indexed by block number.
+static thread_local vector<int> held_number;        // Index into held, or -1. By temporary.
+static thread_local vector<held_value> held;
+static thread_local vector<int> active;             // The held temporaries that are active.
+
+// A block with one predecessor laid out before it continues the extended block of that
+// predecessor: it starts with the registers as they were at the end of the predecessor. Other
+// blocks start extended blocks of their own with nothing in registers. These are indexed by
+// block number.
+//
+static thread_local vector<int> extended_parent;
+static thread_local vector<int> first_order;        // Preorder of the block.
+static thread_local vector<int> last_order;         // Largest preorder of the blocks it reaches.
+static thread_local unordered_map<int, path_state> saved_paths;   // By block number.
+
+
+//
+// Helper functions for values
+//
+
+// Returns the instruction operand for a value operand. Entries must already be in registers.
+static machine_operand machine(const operand &op)
+{
+  switch (op.kind) {
+  case operand::ENTRY:
+    return reg(values.register_of(op.number));
+  case operand::IMMEDIATE:
+    return immediate(op.number);
+  case operand::VARIABLE:
+  default:
+    return contents_of(op.name);
+  }
+}
+
+// Returns an operand addressing memory through the register holding an entry.
+static machine_operand indirect(const operand &op)
+{
+  return reg_indirect(values.register_of(op.number));
+}
+
+// Returns where the value of an operand of the intermediate code is.
+static location locate(const ir_operand &op)
+{
+  location v;
+  v.type = op.type;
+  switch (op.kind) {
+  case ir_operand::TEMPORARY:
+    v = temporaries[op.number];
+    break;
+  case ir_operand::CONSTANT:
+    if (op.type == tLONG) {
+      v.low  = operand::immediate(op.number & 0xFFFF);
+      v.high = operand::immediate(static_cast<unsigned int>(op.number) >> 16);
+    }
+    else {
+      v.low = operand::immediate(op.number);
+    }
+    break;
+  case ir_operand::VARIABLE:
+    v.low = operand::variable(op.name);
+    break;
+  case ir_operand::NONE:
+    break;
+  }
+  return v;
+}
+
+// Returns true and the value if the operand is a constant.
+static bool is_constant(const ir_operand &op, unsigned long &value)
+{
+  if (op.kind != ir_operand::CONSTANT) return false;
+  value = static_cast<unsigned int>(op.number) & value_mask(op.type);
+  return true;
+}
+
+// Returns true if any part of the value is in a register.
+static bool in_registers(const location &v)
+{
+  return v.low.kind == operand::ENTRY || (v.type == tLONG && v.high.kind == operand::ENTRY);
+}
+
+// Makes sure the parts of a value held on the value stack are in registers. This must be done
+// after any new entries needed by an instruction are created because creating an entry might
+// spill one that was loaded.
+//
+static void load(const location &v)
+{
+  if (v.low.kind == operand::ENTRY) values.load(v.low.number);
+  if (v.type == tLONG && v.high.kind == operand::ENTRY) values.load(v.high.number);
+}
+
+// Returns true if the value is in registers that can be changed.
+static bool disposable(const location &v)
+{
+  return in_registers(v) && !v.shared;
+}
+
+// Discards the value stack entries held by a value.
+static void release(const location &v)
+{
+  if (v.shared) return;
+  if (v.low.kind == operand::ENTRY) values.release(v.low.number);
+  if (v.type == tLONG && v.high.kind == operand::ENTRY) values.release(v.high.number);
+}
+
+// Copies an operand into a new entry so that it can be modified. Constants and variables are
+// always copied; an entry is only copied if it is shared.
+//
+static void materialize(operand &op, bool shared = false)
+{
+  if (op.kind != operand::ENTRY || shared) {
+    operand destination = operand::entry(values.push());
+    code->emit(COPY, machine(op), machine(destination));
+    op = destination;
+  }
+}
+
+static void materialize(location &v)
+{
+  materialize(v.low, v.shared);
+  if (v.type == tLONG) materialize(v.high, v.shared);
+  v.shared = false;
+}
+
+// Converts an int value to a long. The MSW of the converted value is zero.
+static void widen(location &v)
+{
+  if (v.type == tINT) {
+    v.type = tLONG;
+    v.high = operand::immediate(0);
+  }
+}
+
+// Converts a long value to an int by discarding its MSW.
+static void narrow(location &v)
+{
+  if (v.type == tLONG) {
+    if (v.high.kind == operand::ENTRY && !v.shared) values.release(v.high.number);
+    v.type = tINT;
+  }
+}
+
+// Creates a new value of the given type on the value stack.
+static location new_value(symbol_type t)
+{
+  location v;
+  v.type = t;
+  v.low  = operand::entry(values.push());
+  if (t == tLONG) v.high = operand::entry(values.push());
+  return v;
+}
+
+
+//
+// Boolean and relational operators
+//
+
+// The boolean operators. Any nonzero operand is true and the result is 0 or 1. When used as the
+// condition of a statement they are branches in the intermediate code instead and the right
+// operand is only evaluated if it is needed.
+//
+static void select_logical(opcode operation, location &l, location &r, location &result)
+{
+  // Both operations commute, so use the operand that is already in a register as the
+  // destination if there is one.
+  //
+  if (!disposable(l) && disposable(r)) swap(l, r);
+  materialize(l);
+  load(l);
+  load(r);
+
+  label done = next_label();
+  if (operation == AND) {
+    // The result is 0 (the value of l) if l is 0. Otherwise it depends on r.
+    code->emit(CMP, immediate(0), machine(l.low));
+    code->emit(JZ, address_of(done));
+    code->emit(COPY, immediate(0), machine(l.low));
+    code->emit(CMP, immediate(0), machine(r.low));
+  }
+  else {
+    code->emit(OR, machine(r.low), machine(l.low));
+  }
+  code->emit(JZ, address_of(done));
+  code->emit(COPY, immediate(1), machine(l.low));
+  code->define(done);
+  release(r);
+  result = l;
+}
+
+// After "cmp right, left" the Z flag is set if the operands are equal and the C flag is clear
+// if left is greater than right (set otherwise). Less than and greater or equal swap the
+// operands so that every comparison is decided by a single jump.
+//
+static const struct {
+  bool   swap;
+  opcode jump_if_true;
+  opcode jump_if_false;
+} comparisons[] = {
+  { false, JZ,  JNZ },  // EQ_TYPE
+  { false, JNZ, JZ  },  // NE_TYPE
+  { true,  JNC, JC  },  // LT_TYPE
+  { false, JNC, JC  },  // GT_TYPE
+  { false, JC,  JNC },  // LE_TYPE
+  { true,  JC,  JNC }   // GE_TYPE
+};
+
+// Compares two values of the same type and sets the flags for the jumps above. For longs the
+// MSWs decide the comparison unless they are equal. Either way the flags are left the same as
+// they would be after comparing two ints.
+//
+static void compare(const location &l, const location &r, relational_type type)
+{
+  const location &left  = comparisons[type].swap ? r : l;
+  const location &right = comparisons[type].swap ? l : r;
+
+  if (left.type == tLONG) {
+    label decide = next_label();
+    code->emit(CMP, machine(right.high), machine(left.high));
+    code->emit(JNZ, address_of(decide));
+    code->emit(CMP, machine(right.low), machine(left.low));
+    code->define(decide);
+  }
+  else {
+    code->emit(CMP, machine(right.low), machine(left.low));
+  }
+}
+
+// Comparisons are unsigned. An int compared with a long is widened with a zero MSW.
+static void select_compare(location &l, location &r, relational_type type, location &result)
+{
+  if (l.type == tLONG || r.type == tLONG) {
+    widen(l);
+    widen(r);
+  }
+  bool is_long = (l.type == tLONG);
+
+  // The result goes into a register used by one of the operands if there is one. Otherwise it
+  // needs a new entry. Neither operand is modified so both can be constants or variables.
+  //
+  operand target;
+  if      (!l.shared && l.low.kind == operand::ENTRY) target = l.low;
+  else if (!l.shared && is_long && l.high.kind == operand::ENTRY) target = l.high;
+  else if (!r.shared && r.low.kind == operand::ENTRY) target = r.low;
+  else if (!r.shared && is_long && r.high.kind == operand::ENTRY) target = r.high;
+  else target = operand::entry(values.push());
+  load(l);
+  load(r);
+  compare(l, r, type);
+
+  // Copying the result into place doesn't change the flags.
+  label done = next_label();
+  code->emit(COPY, immediate(1), machine(target));
+  code->emit(comparisons[type].jump_if_true, address_of(done));
+  code->emit(COPY, immediate(0), machine(target));
+  code->define(done);
+
+  // Discard everything but the result.
+  operand parts[] = { l.low, l.high, r.low, r.high };
+  bool    shared[] = { l.shared, l.shared, r.shared, r.shared };
+  for (int i = 0; i < 4; ++i) {
+    if ((i % 2 == 0 || is_long) && !shared[i] &&
+        parts[i].kind == operand::ENTRY && parts[i].number != target.number) {
+      values.release(parts[i].number);
+    }
+  }
+  result.type = tINT;
+  result.low  = target;
+}
+
+
+//
+// Arithmetic
+//
+
+static void select_add(location &l, location &r, location &result)
+{
+  if (l.type == tLONG || r.type == tLONG) {
+    widen(l);
+    widen(r);
+  }
+
+  // Addition commutes, so add into the operand that is already in registers if there is one.
+  if (!disposable(l) && disposable(r)) swap(l, r);
+  materialize(l);
+  load(l);
+  load(r);
+
+  code->emit(CLC);
+  code->emit(ADD, machine(r.low), machine(l.low));      // Add without carry.
+  if (l.type == tLONG) {
+    code->emit(ADD, machine(r.high), machine(l.high));  // Add with carry.
+  }
+  release(r);
+  result = l;
+}
+
+static void select_sub(location &l, location &r, location &result)
+{
+  if (l.type == tLONG || r.type == tLONG) {
+    widen(l);
+    widen(r);
+  }
+
+  materialize(l);
+  load(l);
+  load(r);
+
+  code->emit(CLC);
+  code->emit(SUB, machine(r.low), machine(l.low));      // Sub without carry.
+  if (l.type == tLONG) {
+    code->emit(SUB, machine(r.high), machine(l.high));  // Sub with carry (borrow).
+  }
+  release(r);
+  result = l;
+}
+
+// Multiplication and division are done with shifts and adds, so they take time proportional to
+// the number of bits in a word rather than to the value of an operand.
+
+// Shifts a value in registers one bit to the left.
+static void shift_left(const location &v)
+{
+  if (v.type == tLONG) {
+    code->emit(CLC);
+    code->emit(ADD, machine(v.low), machine(v.low));
+    code->emit(ADD, machine(v.high), machine(v.high));  // The carry moves into the MSW.
+  }
+  else {
+    code->emit(SHL, machine(v.low));
+  }
+}
+
+// Adds one value in registers to another.
+static void add_to(const location &source, const location &destination)
+{
+  code->emit(CLC);
+  code->emit(ADD, machine(source.low), machine(destination.low));
+  if (destination.type == tLONG) {
+    code->emit(ADD, machine(source.high), machine(destination.high));
+  }
+}
+
+// Multiplies by a constant. The loop is unrolled at compile time: the product is the sum of the
+// multiplicand shifted by the position of each one bit in the multiplier.
+//
+static void multiply_by_constant(location &multiplicand, unsigned long multiplier, location &result)
+{
+  location product = new_value(multiplicand.type);
+  materialize(multiplicand);
+  load(multiplicand);
+  load(product);
+
+  if (multiplier == 0) {
+    code->emit(COPY, immediate(0), machine(product.low));
+    if (product.type == tLONG) code->emit(COPY, immediate(0), machine(product.high));
+  }
+
+  bool first = true;
+  while (multiplier != 0) {
+    if (multiplier & 1) {
+      if (first) {
+        code->emit(COPY, machine(multiplicand.low), machine(product.low));
+        if (product.type == tLONG) {
+          code->emit(COPY, machine(multiplicand.high), machine(product.high));
+        }
+        first = false;
+      }
+      else {
+        add_to(multiplicand, product);
+      }
+    }
+    multiplier >>= 1;
+    if (multiplier != 0) shift_left(multiplicand);
+  }
+  release(multiplicand);
+  result = product;
+}
+
+// Multiplies by a value computed at run time. The multiplier is shifted right one bit at a time
+// and the multiplicand is added to the product for each one bit. The loop ends when no one bits
+// are left. The multiplier may be an int even if the multiplicand is a long.
+//
+static void multiply(location &multiplicand, location &multiplier, location &result)
+{
+  location product = new_value(multiplicand.type);
+  materialize(multiplicand);
+  materialize(multiplier);
+  load(multiplicand);
+  load(multiplier);
+  load(product);
+
+  label top  = next_label();
+  label skip = next_label();
+  label done = next_label();
+  code->emit(COPY, immediate(0), machine(product.low));
+  if (product.type == tLONG) code->emit(COPY, immediate(0), machine(product.high));
+  code->define(top);
+  if (multiplier.type == tLONG) {
+    label go = next_label();
+    code->emit(CMP, immediate(0), machine(multiplier.low));
+    code->emit(JNZ, address_of(go));
+    code->emit(CMP, immediate(0), machine(multiplier.high));
+    code->emit(JZ, address_of(done));
+    code->define(go);
+  }
+  else {
+    code->emit(CMP, immediate(0), machine(multiplier.low));
+    code->emit(JZ, address_of(done));
+  }
+  code->emit(SHR, machine(multiplier.low));
+  code->emit(JNC, address_of(skip));
+  add_to(multiplicand, product);
+  code->define(skip);
+  if (multiplier.type == tLONG) {
+    // Move the low bit of the MSW into the top of the LSW.
+    label shifted = next_label();
+    code->emit(SHR, machine(multiplier.high));
+    code->emit(JNC, address_of(shifted));
+    code->emit(OR, immediate(0x8000), machine(multiplier.low));
+    code->define(shifted);
+  }
+  shift_left(multiplicand);
+  code->emit(JMP, address_of(top));
+  code->define(done);
+  release(multiplicand);
+  release(multiplier);
+  result = product;
+}
+
+static void select_mul(const ir_instruction &i, location &l, location &r, location &result)
+{
+  // Multiplication commutes, so use a constant or an int as the multiplier (on the right).
+  unsigned long value;
+  bool constant_multiplier = is_constant(i.right, value);
+  if (!constant_multiplier && is_constant(i.left, value)) {
+    swap(l, r);
+    constant_multiplier = true;
+  }
+  else if (!constant_multiplier && l.type == tINT && r.type == tLONG) {
+    swap(l, r);
+  }
+
+  if (i.type == tLONG) widen(l);
+  if (constant_multiplier) {
+    multiply_by_constant(l, value & value_mask(l.type), result);
+  }
+  else {
+    multiply(l, r, result);
+  }
+}
+
+// Unsigned restoring division. Each step shifts the top bit of the dividend into the remainder.
+// If the remainder is then at least the divisor, the divisor is subtracted from it and a one bit
+// goes into the quotient, which takes the place of the dividend as it is shifted out. Dividing
+// by zero gives a quotient with every bit set.
+//
+static void select_div(location &l, location &r, location &result)
+{
+  if (l.type == tLONG || r.type == tLONG) {
+    widen(l);
+    widen(r);
+  }
+  bool is_long = (l.type == tLONG);
+
+  location remainder = new_value(l.type);
+  operand  counter   = operand::entry(values.push());
+  materialize(l);
+  load(l);
+  load(r);
+  load(remainder);
+  values.load(counter.number);
+
+  label top      = next_label();
+  label subtract = next_label();
+  label next     = next_label();
+  code->emit(COPY, immediate(0), machine(remainder.low));
+  if (is_long) code->emit(COPY, immediate(0), machine(remainder.high));
+  code->emit(COPY, immediate(is_long ? 32 : 16), machine(counter));
+  code->define(top);
+
+  // Shift the dividend and the remainder left as one value. A carry out of the remainder means
+  // it is certainly larger than the divisor.
+  //
+  code->emit(CLC);
+  code->emit(ADD, machine(l.low), machine(l.low));
+  if (is_long) code->emit(ADD, machine(l.high), machine(l.high));
+  code->emit(ADD, machine(remainder.low), machine(remainder.low));
+  if (is_long) code->emit(ADD, machine(remainder.high), machine(remainder.high));
+  code->emit(JC, address_of(subtract));
+
+  // Compare the remainder with the divisor as a comparison does.
+  if (is_long) {
+    label decide = next_label();
+    code->emit(CMP, machine(r.high), machine(remainder.high));
+    code->emit(JNZ, address_of(decide));
+    code->emit(CMP, machine(r.low), machine(remainder.low));
+    code->define(decide);
+  }
+  else {
+    code->emit(CMP, machine(r.low), machine(remainder.low));
+  }
+  code->emit(JZ, address_of(subtract));
+  code->emit(JC, address_of(next));           // The remainder is less than the divisor.
+
+  code->define(subtract);
+  code->emit(CLC);
+  code->emit(SUB, machine(r.low), machine(remainder.low));
+  if (is_long) code->emit(SUB, machine(r.high), machine(remainder.high));
+  code->emit(INC, machine(l.low));            // The new low bit of the quotient.
+  code->define(next);
+  code->emit(DEC, machine(counter));
+  code->emit(JNZ, address_of(top));
+
+  values.release(counter.number);
+  release(remainder);
+  release(r);
+  result = l;
+}
+
+static void select_shift(const ir_instruction &i, location &value, location &result)
+{
+  materialize(value);
+  load(value);
+  opcode operation = (i.op == IR_SHL) ? SHL : SHR;
+  for (int n = 0; n < i.count; ++n) {
+    code->emit(operation, machine(value.low));
+  }
+  result = value;
+}
+
+
+//
+// Loads and stores
+//
+
+// Longs are loaded into a pair of registers. Because the assembler is too dumb to be able to do
+// math for constants (eg. _varname + 1), a register is needed to address the MSW anyway.
+//
+static void select_load(const ir_instruction &i, location &result)
+{
+  result.type = tLONG;
+  result.low  = operand::entry(values.push());
+  result.high = operand::entry(values.push());
+  load(result);
+  code->emit(COPY, address_of(i.name), machine(result.high));
+  code->emit(COPY, indirect(result.high), machine(result.low));
+  code->emit(INC, machine(result.high));
+  code->emit(COPY, indirect(result.high), machine(result.high));
+}
+
+// The index is turned into the address of the element. No bounds checking is done.
+static void select_load_element(const ir_instruction &i, location &index, location &result)
+{
+  narrow(index);
+  if (i.type == tINT) {
+    materialize(index);
+    load(index);
+    code->emit(CLC);
+    code->emit(ADD, address_of(i.name), machine(index.low));
+    code->emit(COPY, indirect(index.low), machine(index.low));
+    result = index;
+  }
+  else {
+    // For a long, the index is multiplied by two (using a left shift). The address ends up in
+    // the register that receives the MSW.
+    //
+    result.type = tLONG;
+    result.low  = operand::entry(values.push());
+    materialize(index);
+    load(index);
+    load(result);
+    result.high = index.low;
+    code->emit(SHL, machine(index.low));
+    code->emit(CLC);
+    code->emit(ADD, address_of(i.name), machine(index.low));
+    code->emit(COPY, indirect(index.low), machine(result.low));
+    code->emit(INC, machine(index.low));
+    code->emit(COPY, indirect(index.low), machine(index.low));
+  }
+}
+
+static void select_store(const ir_instruction &i, location &value)
+{
+  if (i.type == tINT) {
+    load(value);
+    code->emit(COPY, machine(value.low), contents_of(i.name));
+  }
+  else {
+    // An int gets a 0 for its MSW.
+    widen(value);
+    operand address = operand::entry(values.push());
+    load(value);
+    code->emit(COPY, address_of(i.name), machine(address));
+    code->emit(COPY, machine(value.low), indirect(address));
+    code->emit(INC, machine(address));
+    code->emit(COPY, machine(value.high), indirect(address));
+    values.release(address.number);
+  }
+  release(value);
+}
+
+// The index is turned into the address of the element. No bounds checking is done.
+static void select_store_element(const ir_instruction &i, location &index, location &value)
+{
+  narrow(index);
+  if (i.type == tINT) {
+    materialize(index);
+    load(index);
+    load(value);
+    code->emit(CLC);
+    code->emit(ADD, address_of(i.name), machine(index.low));
+    code->emit(COPY, machine(value.low), indirect(index.low));
+  }
+  else {
+    // An int gets a 0 for its MSW. For a long, the index is multiplied by two (using a left
+    // shift).
+    //
+    widen(value);
+    materialize(index);
+    load(index);
+    load(value);
+    code->emit(SHL, machine(index.low));
+    code->emit(CLC);
+    code->emit(ADD, address_of(i.name), machine(index.low));
+    code->emit(COPY, machine(value.low), indirect(index.low));
+    code->emit(INC, machine(index.low));
+    code->emit(COPY, machine(value.high), indirect(index.low));
+  }
+  release(value);
+  release(index);
+}
+
+
+//
+// Values used more than once
+//
+
+// Returns true if a held value is used after a position in a block, either later in the block
+// or in a block that continues its extended block. Position -1 is before the first instruction.
+//
+static bool used_later(const held_value &h, int block, int position)
+{
+  use here = { first_order[block], position };
+  vector<use>::const_iterator p = upper_bound(h.uses.begin(), h.uses.end(), here);
+  return p != h.uses.end() && p->order <= last_order[block];
+}
+
+// Returns the name of one word of the home of a temporary, declaring it in the function's scope.
+// Identifiers can't start with an underscore, so the name can't be one the program uses.
+//
+static const char *home_name(int temporary, const char *suffix)
+{
+  char name[32];
+  int length = snprintf(name, sizeof(name), "_t%d%s", temporary, suffix);
+  int id = symbols->intern(name, static_cast<size_t>(length));
+  symbols->declare(id, tINT, 0);
+  return symbols->name(id);
+}
+
+// Returns the location of the home of a held temporary. Each word is a variable of its own so
+// that no register is needed to address the MSW.
+//
+static location home(int temporary, symbol_type type)
+{
+  held_value &h = held[held_number[temporary]];
+  if (h.home[0] == 0) {
+    h.home[0] = home_name(temporary, "");
+    h.home[1] = home_name(temporary, "h");
+  }
+  location v;
+  v.type = type;
+  v.low  = operand::variable(h.home[0]);
+  if (type == tLONG) v.high = operand::variable(h.home[1]);
+  return v;
+}
+
+static void store_home(int temporary, const location &v)
+{
+  location h = home(temporary, v.type);
+  code->emit(COPY, machine(v.low), machine(h.low));
+  if (v.type == tLONG) code->emit(COPY, machine(v.high), machine(h.high));
+}
+
+static bool is_temporary(const ir_operand &op, int temporary)
+{
+  return op.kind == ir_operand::TEMPORARY && op.number == temporary;
+}
+
+static void activate(int temporary, const location &v)
+{
+  held[held_number[temporary]].active = true;
+  temporaries[temporary] = v;
+  active.push_back(temporary);
+}
+
+static void deactivate(int temporary)
+{
+  held[held_number[temporary]].active = false;
+  active.erase(find(active.begin(), active.end(), temporary));
+}
+
+// Discards the registers of a held value that isn't needed any more on this path.
+static void drop(int temporary)
+{
+  release(temporaries[temporary]);
+  deactivate(temporary);
+}
+
+// Returns the number of registers used by held values.
+static int held_registers()
+{
+  int count = 0;
+  for (size_t i = 0; i < active.size(); ++i) {
+    const location &v = temporaries[active[i]];
+    if (v.low.kind == operand::ENTRY) ++count;
+    if (v.type == tLONG && v.high.kind == operand::ENTRY) ++count;
+  }
+  return count;
+}
+
+// Returns the number of registers an instruction might use at once if none of its operands were
+// held. The largest is a long division, which needs all seven.
+//
+static int registers_needed(ir_opcode op, symbol_type type, const ir_operand &l, const ir_operand &r)
+{
+  int words = (type == tLONG || l.type == tLONG || r.type == tLONG) ? 2 : 1;
+  switch (op) {
+  case IR_DIV:     return 3 * words + 1;  // The quotient, divisor, remainder, and a counter.
+  case IR_MUL:     return 3 * words;      // The multiplicand, multiplier, and product.
+  case IR_COMPARE: return 2 * words + 1;
+  case IR_STORE:   return words + 1;
+  default:         return 2 * words;
+  }
+}
+
+// Moves held values into their homes until there are enough registers for an instruction using
+// the given operands. Values the instruction doesn't use are moved first. Those used by the
+// instruction stay in their registers as long as there is room since they are counted as
+// registers the instruction needs.
+//
+static void make_room(int needed, const ir_operand &l, const ir_operand &r)
+{
+  for (int pass = 0; pass < 2; ++pass) {
+    for (size_t i = 0; i < active.size(); ++i) {
+      if (held_registers() + needed <= value_stack::register_count) return;
+
+      int t = active[i];
+      bool used = is_temporary(l, t) || is_temporary(r, t);
+      if (used != (pass == 1) || !in_registers(temporaries[t])) continue;
+      if (!held[held_number[t]].global) store_home(t, temporaries[t]);
+      release(temporaries[t]);
+      temporaries[t] = home(t, temporaries[t].type);
+    }
+  }
+}
+
+// Returns where an operand is. A held temporary that is used again on this path is shared. When
+// it is used for the last time its entries are taken off hold so that the instruction can change
+// and release them like those of any other temporary. A temporary used for both operands is
+// shared by both and dropped afterward.
+//
+static location use_operand(const ir_operand &op, const ir_operand &other, int block, int position)
+{
+  if (op.kind != ir_operand::TEMPORARY || held_number[op.number] < 0) return locate(op);
+
+  held_value &h = held[held_number[op.number]];
+  if (!h.active) return home(op.number, op.type);
+
+  location v = temporaries[op.number];
+  if (is_temporary(other, op.number) || used_later(h, block, position)) {
+    v.shared = true;
+    return v;
+  }
+  if (v.low.kind == operand::ENTRY) v.low = operand::entry(values.take(v.low.number));
+  if (v.type == tLONG && v.high.kind == operand::ENTRY) {
+    v.high = operand::entry(values.take(v.high.number));
+  }
+  deactivate(op.number);
+  return v;
+}
+
+static void finish_operands(const ir_operand &l, const ir_operand &r, int block, int position)
+{
+  if (l.kind == ir_operand::TEMPORARY && is_temporary(r, l.number) &&
+      held_number[l.number] >= 0) {
+    const held_value &h = held[held_number[l.number]];
+    if (h.active && !used_later(h, block, position)) drop(l.number);
+  }
+}
+
+// Records where the value of a temporary is once it has been computed.
+static void define(int temporary, const location &v, int block, int position)
+{
+  temporaries[temporary] = v;
+  if (held_number[temporary] < 0) return;
+
+  held_value &h = held[held_number[temporary]];
+  if (h.global) store_home(temporary, v);
+  if (used_later(h, block, position)) {
+    if (v.low.kind == operand::ENTRY) values.hold(v.low.number);
+    if (v.type == tLONG && v.high.kind == operand::ENTRY) values.hold(v.high.number);
+    activate(temporary, v);
+  }
+  else {
+    release(v);
+  }
+}
+
+
+static void select_instruction(const ir_instruction &i, int block, int position)
+{
+  if (!active.empty()) make_room(registers_needed(i.op, i.type, i.left, i.right), i.left, i.right);
+  location l = use_operand(i.left, i.right, block, position);
+  location r = use_operand(i.right, i.left, block, position);
+  location result;
+
+  switch (i.op) {
+  case IR_ADD:           select_add(l, r, result); break;
+  case IR_SUB:           select_sub(l, r, result); break;
+  case IR_MUL:           select_mul(i, l, r, result); break;
+  case IR_DIV:           select_div(l, r, result); break;
+  case IR_SHL:
+  case IR_SHR:           select_shift(i, l, result); break;
+  case IR_AND:           select_logical(AND, l, r, result); break;
+  case IR_OR:            select_logical(OR, l, r, result); break;
+  case IR_COMPARE:       select_compare(l, r, i.relation, result); break;
+  case IR_LOAD:          select_load(i, result); break;
+  case IR_LOAD_ELEMENT:  select_load_element(i, l, result); break;
+  case IR_STORE:         select_store(i, l); break;
+  case IR_STORE_ELEMENT: select_store_element(i, l, r); break;
+  }
+  finish_operands(i.left, i.right, block, position);
+  if (i.result >= 0) define(i.result, result, block, position);
+}
+
+
+//
+// Control flow
+//
+
+static label block_label(int block)
+{
+  if (block_labels[block].number < 0) block_labels[block] = next_label();
+  return block_labels[block];
+}
+
+// Goes to the first successor of a block if a condition is true and to the second otherwise.
+// When one of them is the next block the jump to it is left out.
+//
+static void select_branch(const ir_block &b, int next, opcode jump_if_true, opcode jump_if_false)
+{
+  if (b.successor[1] == next) {
+    code->emit(jump_if_true, address_of(block_label(b.successor[0])));
+  }
+  else if (b.successor[0] == next) {
+    code->emit(jump_if_false, address_of(block_label(b.successor[1])));
+  }
+  else {
+    code->emit(jump_if_true, address_of(block_label(b.successor[0])));
+    code->emit(JMP, address_of(block_label(b.successor[1])));
+  }
+}
+
+// The operands are released before the jump so that the value stack is empty on both paths.
+// Nothing is emitted for that since the operands are in registers.
+//
+static void select_terminator(const ir_block &b, int block, int next)
+{
+  // A branch needs both of its operands in registers at once, as a subtraction does.
+  int position = static_cast<int>(b.code.size());
+  if (!active.empty()) make_room(registers_needed(IR_SUB, tINT, b.left, b.right), b.left, b.right);
+  location l = use_operand(b.left, b.right, block, position);
+  location r = use_operand(b.right, b.left, block, position);
+
+  switch (b.exit) {
+  case IR_END:
+    break;
+
+  case IR_JUMP:
+    if (b.successor[0] != next) code->emit(JMP, address_of(block_label(b.successor[0])));
+    break;
+
+  case IR_BRANCH:
+    if (l.type == tLONG || r.type == tLONG) {
+      widen(l);
+      widen(r);
+    }
+    load(l);
+    load(r);
+    compare(l, r, b.relation);
+    release(l);
+    release(r);
+    select_branch(b, next, comparisons[b.relation].jump_if_true,
+                  comparisons[b.relation].jump_if_false);
+    break;
+
+  case IR_TEST:
+    if (l.type == tLONG) {
+      // A long is false only if both words are zero.
+      if (l.shared) materialize(l);
+      materialize(l.low);
+      load(l);
+      code->emit(OR, machine(l.high), machine(l.low));
+    }
+    else {
+      load(l);
+      code->emit(CMP, immediate(0), machine(l.low));
+    }
+    release(l);
+    select_branch(b, next, JNZ, JZ);
+    break;
+
+  case IR_RETURN:
+    // Leave the result on the top of the stack (MSW first).
+    if (b.left.kind != ir_operand::NONE) {
+      load(l);
+      if (l.type == tLONG) {
+        code->emit(PUSH, machine(l.high));
+      }
+      code->emit(PUSH, machine(l.low));
+      release(l);
+    }
+    code->emit(HALT);
+    break;
+  }
+  finish_operands(b.left, b.right, block, position);
+}
+
+
+//
+// Extended blocks
+//
+
+// Finds the extended blocks and numbers the blocks of each one in preorder, so that the blocks
+// continuing from a block are numbered after it and before any other block.
+//
+static void find_extended_blocks(const ir_function &function)
+{
+  const vector<int> &layout = function.layout();
+  int count = function.block_count();
+  vector<int> position(count, -1);
+  for (size_t p = 0; p < layout.size(); ++p) {
+    position[layout[p]] = static_cast<int>(p);
+  }
+
+  extended_parent.assign(count, -1);
+  vector<int> first_child(count, -1);
+  vector<int> next_sibling(count, -1);
+  for (size_t p = layout.size(); p > 0; --p) {
+    int n = layout[p - 1];
+    const vector<int> &predecessors = function.block(n).predecessors;
+    if (predecessors.size() == 1 && position[predecessors[0]] >= 0 &&
+        position[predecessors[0]] < position[n]) {
+      extended_parent[n] = predecessors[0];
+      next_sibling[n] = first_child[predecessors[0]];
+      first_child[predecessors[0]] = n;
+    }
+  }
+
+  // The blocks are walked without recursion. A block's complement marks the point where the
+  // blocks continuing from it are done.
+  //
+  first_order.assign(count, -1);
+  last_order.assign(count, -1);
+  int order = 0;
+  vector<int> pending;
+  for (size_t p = 0; p < layout.size(); ++p) {
+    if (extended_parent[layout[p]] >= 0) continue;
+    pending.push_back(layout[p]);
+    while (!pending.empty()) {
+      int n = pending.back();
+      pending.pop_back();
+      if (n < 0) {
+        last_order[~n] = order - 1;
+        continue;
+      }
+      first_order[n] = order++;
+      pending.push_back(~n);
+      for (int c = first_child[n]; c >= 0; c = next_sibling[c]) {
+        pending.push_back(c);
+      }
+    }
+  }
+}
+
+// Counts the uses of each temporary and finds the ones that must be held.
+static void find_held_values(const ir_function &function, vector<int> &uses)
+{
+  int count = function.temporary_count();
+  vector<int>  definition(count, -1);
+  vector<bool> elsewhere(count, false);
+  uses.assign(count, 0);
+
+  for (int n = 0; n < function.block_count(); ++n) {
+    const ir_block &b = function.block(n);
+    for (size_t i = 0; i < b.code.size(); ++i) {
+      if (b.code[i].result >= 0) definition[b.code[i].result] = n;
+    }
+  }
+  for (int n = 0; n < function.block_count(); ++n) {
+    const ir_block &b = function.block(n);
+    for (size_t i = 0; i <= b.code.size(); ++i) {
+      const ir_operand &l = (i < b.code.size()) ? b.code[i].left  : b.left;
+      const ir_operand &r = (i < b.code.size()) ? b.code[i].right : b.right;
+      if (l.kind == ir_operand::TEMPORARY) {
+        ++uses[l.number];
+        if (definition[l.number] != n) elsewhere[l.number] = true;
+      }
+      if (r.kind == ir_operand::TEMPORARY) {
+        ++uses[r.number];
+        if (definition[r.number] != n) elsewhere[r.number] = true;
+      }
+    }
+  }
+
+  held_number.assign(count, -1);
+  held.clear();
+  for (int t = 0; t < count; ++t) {
+    if (uses[t] > 1 || elsewhere[t]) {
+      held_value h;
+      h.block   = definition[t];
+      h.global  = false;
+      h.active  = false;
+      h.home[0] = h.home[1] = 0;
+      held_number[t] = static_cast<int>(held.size());
+      held.push_back(h);
+    }
+  }
+  if (held.empty()) return;
+
+  for (int n = 0; n < function.block_count(); ++n) {
+    const ir_block &b = function.block(n);
+    for (size_t i = 0; i <= b.code.size(); ++i) {
+      const ir_operand &l = (i < b.code.size()) ? b.code[i].left  : b.left;
+      const ir_operand &r = (i < b.code.size()) ? b.code[i].right : b.right;
+      use here = { first_order[n], static_cast<int>(i) };
+      if (l.kind == ir_operand::TEMPORARY && held_number[l.number] >= 0) {
+        held[held_number[l.number]].uses.push_back(here);
+      }
+      if (r.kind == ir_operand::TEMPORARY && held_number[r.number] >= 0) {
+        held[held_number[r.number]].uses.push_back(here);
+      }
+    }
+  }
+
+  // A value used outside of the extended block below the block computing it is global.
+  for (size_t h = 0; h < held.size(); ++h) {
+    vector<use> &u = held[h].uses;
+    sort(u.begin(), u.end());
+    held[h].global = u.front().order < first_order[held[h].block] ||
+                     u.back().order  > last_order[held[h].block];
+  }
+}
+
+// A block continuing an extended block starts with the held values its predecessor had at its
+// end, less the ones it doesn't use. Other blocks start with nothing in registers.
+//
+static void start_block(int block)
+{
+  while (!active.empty()) deactivate(active.back());
+  int parent = extended_parent[block];
+  if (parent < 0) {
+    values = value_stack();
+    return;
+  }
+
+  unordered_map<int, path_state>::iterator p = saved_paths.find(parent);
+  values = p->second.values;
+  for (size_t i = 0; i < p->second.active.size(); ++i) {
+    activate(p->second.active[i], p->second.where[i]);
+  }
+  if (--p->second.waiting == 0) saved_paths.erase(p);
+
+  for (size_t i = active.size(); i > 0; --i) {
+    int t = active[i - 1];
+    if (!used_later(held[held_number[t]], block, -1)) drop(t);
+  }
+}
+
+// Saves the held values at the end of a block for the blocks continuing from it.
+static void end_block(const ir_block &b, int block)
+{
+  int waiting = 0;
+  for (int s = 0; s < b.successor_count(); ++s) {
+    if (extended_parent[b.successor[s]] == block) ++waiting;
+  }
+  if (waiting == 0) return;
+
+  path_state &state = saved_paths[block];
+  state.values  = values;
+  state.active  = active;
+  state.waiting = waiting;
+  state.where.clear();
+  for (size_t i = 0; i < active.size(); ++i) {
+    state.where.push_back(temporaries[active[i]]);
+  }
+}
+
+
+void select_instructions(const ir_function &function)
+{
+  vector<int> uses;
+  find_extended_blocks(function);
+  find_held_values(function, uses);
+
+  const vector<int> &layout = function.layout();
+  temporaries.assign(function.temporary_count(), location());
+  block_labels.assign(function.block_count(), label());
+
+  for (size_t position = 0; position < layout.size(); ++position) {
+    int number = layout[position];
+    const ir_block &b = function.block(number);
+    int next = (position + 1 < layout.size()) ? layout[position + 1] : -1;
+
+    // A block needs a label if any of its predecessors doesn't fall through to it.
+    bool jumped_to = false;
+    for (size_t p = 0; p < b.predecessors.size(); ++p) {
+      if (position == 0 || layout[position - 1] != b.predecessors[p]) jumped_to = true;
+    }
+    if (jumped_to) code->define(block_label(number));
+
+    // Temporaries that are never used are released as soon as they are computed. That only
+    // happens when an error stops the expression using them from being translated.
+    //
+    start_block(number);
+    for (size_t i = 0; i < b.code.size(); ++i) {
+      select_instruction(b.code[i], number, static_cast<int>(i));
+      if (b.code[i].result >= 0 && uses[b.code[i].result] == 0) {
+        release(temporaries[b.code[i].result]);
+      }
+    }
+    select_terminator(b, number, next);
+    end_block(b, number);
+  }
+
+  values = value_stack();
+  temporaries.clear();
+  block_labels.clear();
+  held_number.clear();
+  held.clear();
+  active.clear();
+  extended_parent.clear();
+  first_order.clear();
+  last_order.clear();
+  saved_paths.clear();
+}
@@ -0,0 +1,39 @@
+/****************************************************************************
+FILE      : instruction-selection.h
+SUBJECT   : Declaration of the instruction selector.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Instruction selection turns the intermediate code of a function (see
+intermediate-code.h) into VuPP instructions. Temporaries are given
+registers by a value_stack (see value-stack.h) in the order they are
+computed, which is the Sethi-Ullman order chosen when the syntax tree
+was annotated. Blocks are written in their layout order and a block that
+is followed by one of its successors falls through to it.
+
+A temporary used more than once (see value-numbering.h) is held in its
+registers until its last use. Registers are kept across blocks only
+within an extended block: a block with one predecessor laid out before
+it continues with the registers that predecessor ended with. A value
+used outside of the extended block computing it, or pushed out of its
+registers when more are needed, is stored in a word or two of memory of
+its own (its home) and loaded from there when it is used.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef INSTRUCTION_SELECTION_H
+#define INSTRUCTION_SELECTION_H
+
+#include "intermediate-code.h"
+
+// Appends the instructions for a function to the current instruction list (see code in
+// instruction-list.h). The function's predecessors must have been recorded by finish().
+//
+void select_instructions(const ir_function &function);
+
+#endif
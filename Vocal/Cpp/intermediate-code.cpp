@@ -0,0 +1,208 @@
+/****************************************************************************
+FILE      : intermediate-code.cpp
+SUBJECT   : Implementation of the three-address intermediate code.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "intermediate-code.h"
+
+thread_local ir_function *ir = 0;
+
+//
+// Class ir_block
+//
+
+ir_block::ir_block()
+  : exit(IR_END), relation(EQ_TYPE), left(ir_operand::none()), right(ir_operand::none())
+{
+  successor[0] = successor[1] = -1;
+}
+
+
+int ir_block::successor_count() const
+{
+  switch (exit) {
+  case IR_JUMP:   return 1;
+  case IR_BRANCH:
+  case IR_TEST:   return 2;
+  default:        return 0;
+  }
+}
+
+//
+// Class ir_function
+//
+
+ir_function::ir_function()
+  : current(0), terminated(false), temporaries(0)
+{
+  blocks.push_back(ir_block());
+  order.push_back(0);
+}
+
+
+int ir_function::new_block()
+{
+  blocks.push_back(ir_block());
+  return static_cast<int>(blocks.size()) - 1;
+}
+
+
+void ir_function::start(int block)
+{
+  if (!terminated) jump(block);
+  order.push_back(block);
+  current    = block;
+  terminated = false;
+}
+
+
+// Instructions that follow a terminator can't be reached. They still get a block of their own
+// so that every block has one terminator at its end.
+//
+ir_instruction &ir_function::append(ir_opcode op, symbol_type type, bool has_result)
+{
+  if (terminated) start(new_block());
+
+  ir_instruction i;
+  i.op       = op;
+  i.type     = type;
+  i.result   = has_result ? temporaries++ : -1;
+  i.left     = ir_operand::none();
+  i.right    = ir_operand::none();
+  i.name     = 0;
+  i.relation = EQ_TYPE;
+  i.count    = 0;
+  blocks[current].code.push_back(i);
+  return blocks[current].code.back();
+}
+
+
+ir_operand ir_function::compute(
+  ir_opcode op, symbol_type type, const ir_operand &left, const ir_operand &right)
+{
+  ir_instruction &i = append(op, type, true);
+  i.left  = left;
+  i.right = right;
+  return ir_operand::temporary(i.result, type);
+}
+
+
+ir_operand ir_function::compare(
+  relational_type relation, const ir_operand &left, const ir_operand &right)
+{
+  ir_instruction &i = append(IR_COMPARE, tINT, true);
+  i.left     = left;
+  i.right    = right;
+  i.relation = relation;
+  return ir_operand::temporary(i.result, tINT);
+}
+
+
+ir_operand ir_function::shift(ir_opcode op, const ir_operand &value, int count)
+{
+  ir_instruction &i = append(op, tINT, true);
+  i.left  = value;
+  i.count = count;
+  return ir_operand::temporary(i.result, tINT);
+}
+
+
+ir_operand ir_function::load(const char *name, symbol_type type)
+{
+  ir_instruction &i = append(IR_LOAD, type, true);
+  i.name = name;
+  return ir_operand::temporary(i.result, type);
+}
+
+
+ir_operand ir_function::load_element(const char *array, symbol_type type, const ir_operand &index)
+{
+  ir_instruction &i = append(IR_LOAD_ELEMENT, type, true);
+  i.name = array;
+  i.left = index;
+  return ir_operand::temporary(i.result, type);
+}
+
+
+void ir_function::store(const char *name, symbol_type type, const ir_operand &value)
+{
+  ir_instruction &i = append(IR_STORE, type, false);
+  i.name = name;
+  i.left = value;
+}
+
+
+void ir_function::store_element(
+  const char *array, symbol_type type, const ir_operand &index, const ir_operand &value)
+{
+  ir_instruction &i = append(IR_STORE_ELEMENT, type, false);
+  i.name  = array;
+  i.left  = index;
+  i.right = value;
+}
+
+
+ir_block &ir_function::terminate(ir_terminator exit)
+{
+  if (terminated) start(new_block());
+  terminated = true;
+  blocks[current].exit = exit;
+  return blocks[current];
+}
+
+
+void ir_function::jump(int target)
+{
+  ir_block &b = terminate(IR_JUMP);
+  b.successor[0] = target;
+}
+
+
+void ir_function::branch(relational_type relation, const ir_operand &left,
+                         const ir_operand &right, int if_true, int if_false)
+{
+  ir_block &b = terminate(IR_BRANCH);
+  b.relation     = relation;
+  b.left         = left;
+  b.right        = right;
+  b.successor[0] = if_true;
+  b.successor[1] = if_false;
+}
+
+
+void ir_function::test(const ir_operand &value, int if_true, int if_false)
+{
+  ir_block &b = terminate(IR_TEST);
+  b.left         = value;
+  b.successor[0] = if_true;
+  b.successor[1] = if_false;
+}
+
+
+void ir_function::return_value(const ir_operand &value)
+{
+  ir_block &b = terminate(IR_RETURN);
+  b.left = value;
+}
+
+
+void ir_function::finish()
+{
+  for (std::size_t i = 0; i < blocks.size(); ++i) {
+    blocks[i].predecessors.clear();
+  }
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    const ir_block &b = blocks[order[i]];
+    for (int s = 0; s < b.successor_count(); ++s) {
+      blocks[b.successor[s]].predecessors.push_back(order[i]);
+    }
+  }
+}
@@ -0,0 +1,175 @@
+/****************************************************************************
+FILE      : intermediate-code.h
+SUBJECT   : Declaration of the three-address intermediate code.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+The syntax tree of a function is translated into three-address code
+before any VuPP instructions are chosen. Each instruction computes at
+most one value into a numbered temporary. Temporaries are assigned
+exactly once (as in SSA form) and they are typed: a value is an int (one
+word) or a long (two words). Variables stay in memory; int variables can
+be used directly as operands since VuPP can address them. The
+instructions are grouped into basic blocks. Each block ends with one
+terminator (a jump, a conditional branch, or a return) and the blocks
+form the function's control flow graph. Instruction selection (see
+instruction-selection.h) turns this into VuPP code.
+
+Operations that VuPP doesn't have (multiplication, division, and the
+boolean and relational operators used as values) are single instructions
+here. Instruction selection expands them into loops and jumps of their
+own. Only the control flow of statements and of conditions is in the
+graph.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef INTERMEDIATE_CODE_H
+#define INTERMEDIATE_CODE_H
+
+#include <vector>
+#include "symbol-table.h"
+
+enum relational_type
+  { EQ_TYPE, NE_TYPE, LT_TYPE, GT_TYPE, LE_TYPE, GE_TYPE };
+
+// A value used by an instruction. Constants keep the value their num_node had. A temporary or a
+// constant used where a wider value is expected is widened with a zero MSW and a long used
+// where an int is expected gives its LSW.
+//
+struct ir_operand {
+  enum kind_type { NONE, TEMPORARY, CONSTANT, VARIABLE };
+
+  kind_type   kind;
+  symbol_type type;    // tINT or tLONG.
+  int         number;  // Temporary or constant.
+  const char *name;    // Int variable, without the leading underscore.
+
+  static ir_operand none()
+    { ir_operand op = { NONE, tERROR, 0, 0 }; return op; }
+  static ir_operand temporary(int n, symbol_type t)
+    { ir_operand op = { TEMPORARY, t, n, 0 }; return op; }
+  static ir_operand constant(int n, symbol_type t)
+    { ir_operand op = { CONSTANT, t, n, 0 }; return op; }
+  static ir_operand variable(const char *n)
+    { ir_operand op = { VARIABLE, tINT, 0, n }; return op; }
+};
+
+// Returns the bits of a value that a variable of the given type holds. VuPP arithmetic wraps
+// around so constant values are reduced with this.
+//
+inline unsigned long value_mask(symbol_type t)
+{
+  return t == tLONG ? 0xFFFFFFFFUL : 0xFFFFUL;
+}
+
+enum ir_opcode {
+  IR_ADD, IR_SUB, IR_MUL, IR_DIV,  // result = left op right
+  IR_SHL, IR_SHR,                  // result = left shifted by count (ints only)
+  IR_AND, IR_OR,                   // result = 0 or 1 (ints only, both operands evaluated)
+  IR_COMPARE,                      // result = 0 or 1 as left relation right
+  IR_LOAD,                         // result = long variable name
+  IR_LOAD_ELEMENT,                 // result = name[left]
+  IR_STORE,                        // name = left
+  IR_STORE_ELEMENT                 // name[left] = right
+};
+
+struct ir_instruction {
+  ir_opcode       op;
+  symbol_type     type;      // The type of the result, or of the variable or element stored.
+  int             result;    // The temporary computed, or -1 for stores.
+  ir_operand      left;
+  ir_operand      right;
+  const char     *name;      // The variable or array of a load or store.
+  relational_type relation;  // For IR_COMPARE.
+  int             count;     // For shifts.
+};
+
+// How a block ends. A block whose terminator is IR_END is the last one in the function and
+// execution runs off its end.
+//
+enum ir_terminator { IR_END, IR_JUMP, IR_BRANCH, IR_TEST, IR_RETURN };
+
+struct ir_block {
+  std::vector<ir_instruction> code;
+  ir_terminator   exit;
+  relational_type relation;      // IR_BRANCH: taken if left relation right.
+  ir_operand      left;          // IR_TEST: taken if left is nonzero. IR_RETURN: the value.
+  ir_operand      right;
+  int             successor[2];  // Where execution goes if the branch is taken or not. A jump
+                                 // only has the first.
+  std::vector<int> predecessors; // Set by ir_function::finish().
+
+  ir_block();
+
+  // Returns the number of blocks execution can go to from this one (0, 1, or 2).
+  int successor_count() const;
+};
+
+// The intermediate code of one function. The blocks are numbered in the order they are made and
+// laid out in the order they are started; the first block is the entry.
+//
+class ir_function {
+public:
+  ir_function();
+
+  // Makes a new block. It isn't laid out until it is started.
+  int new_block();
+
+  // Places a block after the blocks already laid out and appends instructions to it from now
+  // on. If the current block has no terminator yet it gets a jump to the new block.
+  //
+  void start(int block);
+
+  // Appends an instruction computing a value and returns the temporary holding the value.
+  ir_operand compute(ir_opcode op, symbol_type type, const ir_operand &left,
+                     const ir_operand &right = ir_operand::none());
+  ir_operand compare(relational_type relation, const ir_operand &left, const ir_operand &right);
+  ir_operand shift(ir_opcode op, const ir_operand &value, int count);
+  ir_operand load(const char *name, symbol_type type);
+  ir_operand load_element(const char *array, symbol_type type, const ir_operand &index);
+
+  // Appends an instruction storing a value in a variable or an array element of the given type.
+  void store(const char *name, symbol_type type, const ir_operand &value);
+  void store_element(const char *array, symbol_type type,
+                     const ir_operand &index, const ir_operand &value);
+
+  // These end the current block. Instructions appended after them go into a new block that no
+  // other block leads to.
+  //
+  void jump(int target);
+  void branch(relational_type relation, const ir_operand &left, const ir_operand &right,
+              int if_true, int if_false);
+  void test(const ir_operand &value, int if_true, int if_false);
+  void return_value(const ir_operand &value);
+
+  // Records the predecessors of every block. Done once, after the function is translated.
+  void finish();
+
+  int block_count() const { return static_cast<int>(blocks.size()); }
+  int temporary_count() const { return temporaries; }
+  ir_block &block(int number) { return blocks[number]; }
+  const ir_block &block(int number) const { return blocks[number]; }
+
+  // Returns the blocks in the order they are laid out.
+  const std::vector<int> &layout() const { return order; }
+
+private:
+  std::vector<ir_block> blocks;
+  std::vector<int>      order;
+  int                   current;
+  bool                  terminated;   // True if the current block has its terminator.
+  int                   temporaries;
+
+  ir_instruction &append(ir_opcode op, symbol_type type, bool has_result);
+  ir_block &terminate(ir_terminator exit);
+};
+
+// The intermediate code of the function being compiled. Each thread has its own.
+extern thread_local ir_function *ir;
+
+#endif
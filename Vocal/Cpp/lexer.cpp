@@ -0,0 +1,130 @@
+/****************************************************************************
+FILE      : lexer.cpp
+SUBJECT   : Implementation of Vocal's lexical analyzer.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include <cstring>
+#include "lexer.h"
+#include "node-types.h"
+#include "vocal.tab.hpp"
+
+static bool is_letter(char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+static bool is_identifier_char(char c)
+{
+  return is_letter(c) || is_digit(c) || c == '_';
+}
+
+// Returns the token code of a keyword or IDENTIFIER if the word isn't a keyword. Keywords are
+// grouped by length so that at most a few are compared.
+//
+static int keyword(const char *word, std::size_t length)
+{
+  static const struct {
+    const char *text;
+    int         code;
+  } keywords[] = {
+    { "if",       IF       }, { "is",       IS      }, { "of",       OF     },
+    { "or",       OR       }, { "and",      AND     }, { "end",      END    },
+    { "int",      INT      }, { "not",      NOT     }, { "else",     ELSE   },
+    { "long",     LONG     }, { "loop",     LOOP    }, { "then",     THEN   },
+    { "array",    ARRAY    }, { "begin",    tBEGIN  }, { "while",    WHILE  },
+    { "return",   RETURN   }, { "returns",  RETURNS }, { "function", FUNCTION }
+  };
+  // The keywords of each length start at first[length] and end at first[length + 1].
+  static const int first[] = { 0, 0, 0, 4, 8, 12, 15, 16, 17, 18 };
+  static const std::size_t longest = 8;
+
+  if (length > longest) return IDENTIFIER;
+  for (int i = first[length]; i < first[length + 1]; ++i) {
+    if (std::memcmp(keywords[i].text, word, length) == 0) return keywords[i].code;
+  }
+  return IDENTIFIER;
+}
+
+
+lexer::lexer(const char *text, std::size_t size)
+  : start(text), end(text + size), position(text), line_number(1)
+{ }
+
+
+int lexer::next(token &value)
+{
+  // Skip white space and comments.
+  while (position != end) {
+    char c = *position;
+    if (c == '\n') {
+      ++line_number;
+      ++position;
+    }
+    else if (c == ' ' || c == '\t' || c == '\f' || c == '\r') {
+      ++position;
+    }
+    else if (c == '-' && position + 1 != end && position[1] == '-') {
+      // A comment runs to the end of the line. The newline is counted above.
+      const void *newline = std::memchr(position, '\n', end - position);
+      position = newline ? static_cast<const char *>(newline) : end;
+    }
+    else {
+      break;
+    }
+  }
+  if (position == end) return 0;
+
+  const char *first = position;
+  char c = *position++;
+
+  if (is_letter(c)) {
+    while (position != end && is_identifier_char(*position)) ++position;
+    std::size_t length = position - first;
+    int code = keyword(first, length);
+    if (code == IDENTIFIER) {
+      value.offset = first - start;
+      value.length = length;
+    }
+    return code;
+  }
+
+  if (is_digit(c)) {
+    // The value wraps around like atoi() does when given too many digits.
+    unsigned long number = c - '0';
+    while (position != end && is_digit(*position)) {
+      number = 10 * number + (*position++ - '0');
+    }
+    value.number = static_cast<int>(number);
+    if (position != end && (*position == 'l' || *position == 'L')) {
+      ++position;
+      return LNUM;
+    }
+    return NUM;
+  }
+
+  // Two character operators.
+  if (position != end) {
+    char second = *position;
+    if (c == ':' && second == '=') { ++position; return ASSIGN; }
+    if (c == '=' && second == '=') { ++position; return EQ;     }
+    if (c == '!' && second == '=') { ++position; return NE;     }
+    if (c == '<' && second == '=') { ++position; return LE;     }
+    if (c == '>' && second == '=') { ++position; return GE;     }
+  }
+
+  // Anything else is returned as itself.
+  return static_cast<unsigned char>(c);
+}
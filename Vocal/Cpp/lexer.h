@@ -0,0 +1,55 @@
+/****************************************************************************
+FILE      : lexer.h
+SUBJECT   : Declaration of Vocal's lexical analyzer.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+The lexer is a hand written state machine over a buffer of source text
+(usually a mapped source_file). It keeps all of its state in the lexer
+object, so several can run at once. Tokens don't own any storage: an
+identifier is reported as the offset and length of its text in the
+buffer and it is up to the caller to intern it.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <cstddef>
+
+// The value of a token. Only the members for the kind of token returned are set.
+struct token {
+  int         number;  // NUM and LNUM.
+  std::size_t offset;  // IDENTIFIER. The position of the name in the source text.
+  std::size_t length;  // IDENTIFIER. The length of the name.
+};
+
+class lexer {
+public:
+  // The text must stay valid as long as the lexer is used. It need not be null terminated.
+  lexer(const char *text, std::size_t size);
+
+  // Scans the next token and returns its kind: a token code from vocal.tab.hpp, a single
+  // character, or zero at the end of the text.
+  //
+  int next(token &value);
+
+  // Returns the number of the line the lexer has reached.
+  int line() const { return line_number; }
+
+  // Returns the text being scanned.
+  const char *text() const { return start; }
+
+private:
+  const char *start;
+  const char *end;
+  const char *position;
+  int         line_number;
+};
+
+#endif
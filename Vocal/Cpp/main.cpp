@@ -11,101 +11,427 @@ Please send comments or bug reports to
      PChapin@vtc.vsc.edu
 ****************************************************************************/
 
+#include "arena.h"
+#include "code-buffer.h"
+#include "compile-cache.h"
+#include "instruction-list.h"
+#include "instruction-selection.h"
+#include "intermediate-code.h"
+#include "lexer.h"
 #include "node-types.h"
+#include "object-file.h"
+#include "peephole.h"
+#include "source-file.h"
+#include "statistics.h"
+#include "symbol-table.h"
+#include "thread-pool.h"
+#include "translation-unit.h"
+#include "value-numbering.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <fstream>
 #include <stdio.h>
+#include <thread>
+#include <vector>
 
 
-std::ofstream output;
+extern int yyparse(lexer &scanner, translation_unit &unit);
 
-extern stmt_node *root_node;
+// Identifies this version of the compiler in cache keys (see compiler_identity()).
+static const char compiler_version[] = "vocalc 2026.10";
 
+// True if object files are written instead of assembly language (--emit=oj).
+static bool emit_object = false;
+
+// Previously compiled files. Only used if --cache-dir is given.
+static compile_cache cache;
+
+// True if --time-passes or --stats was given. Each job then collects statistics in its
+// translation_unit or function_unit.
+static bool collecting = false;
+
+// Returns a string that changes whenever the compiler does. The version alone isn't enough
+// because it isn't changed for every build, so the executable itself is hashed too if it can
+// be found.
+//
+static std::string compiler_identity()
+{
+  std::string identity(compiler_version);
+  source_file executable;
+  if (executable.open("/proc/self/exe")) {
+    hasher hash;
+    hash.add(executable.text(), executable.size());
+    identity += ' ';
+    identity += hash.digest();
+  }
+  return identity;
+}
+
+
+// Reads a source file and builds the syntax tree of each function in it. If the compile cache
+// has the output of the same source, that is used instead and the file isn't parsed.
+//
+static void parse_file(translation_unit &unit)
+{
+  if (!unit.source.open(unit.source_name.c_str())) {
+    unit.messages << "Error opening " << unit.source_name << "!!!" << '\n';
+    unit.status = 1;
+    return;
+  }
+  if (stats) ++stats->files;
+
+  if (cache.active()) {
+    pass_timer timing(CACHE_PASS);
+    unit.cache_key = cache.key(unit.source.text(), unit.source.size());
+    if (cache.fetch(unit.cache_key, unit.output_name)) {
+      if (stats) ++stats->cache_hits;
+      unit.cached = true;
+      unit.source.close();
+      return;
+    }
+  }
+
+  // There is no current function until the parser sees one.
+  symbols    = 0;
+  node_arena = 0;
+  lexer scanner(unit.source.text(), unit.source.size());
+
+  // The lexer and symbol table are timed separately. Their time isn't counted as parsing.
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  long long nested = stats ? stats->pass_time[LEX_PASS] + stats->pass_time[SYMBOL_PASS] : 0;
+  if (yyparse(scanner, unit) != 0) unit.status = 1;
+  if (stats) {
+    nested = stats->pass_time[LEX_PASS] + stats->pass_time[SYMBOL_PASS] - nested;
+    stats->pass_time[PARSE_PASS] += nanoseconds_since(start) - nested;
+  }
+  symbols    = 0;
+  node_arena = 0;
+
+  // Names have been copied into the symbol tables so the text is no longer needed.
+  unit.source.close();
+}
+
+
+// Generates the code of one function and cleans it up. The function's scope, syntax tree,
+// intermediate code, and code are made the current ones on this thread while it is compiled.
+//
+static void compile_function(function_unit &function)
+{
+  ir_function intermediate;
+  function.code = new instruction_list;
+  node_arena  = &function.nodes;
+  symbols     = &function.symbols;
+  ir          = &intermediate;
+  code        = function.code;
+  diagnostics = &function.messages;
+  error_count = &function.errors;
+  reset_labels();
+
+  // Resolve the names used in the function, translate it into intermediate code, remove the
+  // values it computes more than once, choose the instructions for the rest, and clean them up.
+  {
+    pass_timer timing(BIND_PASS);
+    function.body->bind();
+  }
+  {
+    pass_timer timing(IR_PASS);
+    function.body->generate();
+    intermediate.finish();
+  }
+  if (stats) stats->blocks += static_cast<long>(intermediate.layout().size());
+  {
+    pass_timer timing(VALUE_PASS);
+    int redundant = number_values(intermediate);
+    if (stats) stats->redundant += redundant;
+  }
+  {
+    pass_timer timing(SELECT_PASS);
+    select_instructions(intermediate);
+  }
+  if (stats) stats->instructions += function.code->instruction_count();
+  {
+    pass_timer timing(PEEPHOLE_PASS);
+    function.removed = peephole_optimize(*function.code);
+  }
+  function.label_count = reset_labels();
+  if (stats) {
+    ++stats->functions;
+    stats->labels  += function.label_count;
+    stats->removed += function.removed;
+  }
+
+  node_arena  = 0;
+  symbols     = 0;
+  ir          = 0;
+  code        = 0;
+  diagnostics = &std::cerr;
+  error_count = 0;
+
+  // Discard the tree.
+  function.body = 0;
+  function.nodes.release();
+}
+
+
+// Generates locations for the variables declared in a function.
+static void write_variables(code_buffer &output, const symbol_table &scope, const char *prefix)
+{
+  std::vector<const symbol_attrs *> variables = declared_variables(scope);
+  for (std::vector<const symbol_attrs *>::iterator myit = variables.begin(); 
+       myit != variables.end(); myit++) {
+
+    // See how much storage we need for this type.
+    switch((*myit)->vartype) {
+    case tINT:
+      // Ints only need one word.
+      output << "_" << prefix << (*myit)->name << ": DW 0" << '\n';
+      break;
+    case tLONG:
+      // Longs need two words.
+      output << "_" << prefix << (*myit)->name << ": DW 0" << '\n'
+             << "    DW 0" << '\n';
+      break;
+    case tINTARRAY:
+      // An array of ints needs one word per element.
+      // Assuming there is at least 1 element.
+      output << "_" << prefix << (*myit)->name << ": DW 0" << '\n';
+      for (int i = 1; i < (*myit)->num_elements; ++i) {
+        output << "    DW 0" << '\n';
+      }
+      break;
+    case tLONGARRAY:
+      // An array of longs needs two words per element.
+      // Assuming there is at least 1 element.
+      output << "_" << prefix << (*myit)->name << ": DW 0" << '\n'
+             << "    DW 0" << '\n';
+      for (int i = 1; i < (*myit)->num_elements; ++i) {
+        output << "    DW 0" << '\n'
+               << "    DW 0" << '\n';
+      }
+      break;
+    default:
+      std::cerr << "ERROR: " << (*myit)->name << " has unknown type!\n" << std::endl;
+    }
+  }
+}
+
+
+// Writes a translation unit as assembly language. The code of its functions is written in
+// source order. When there is more than one function their variables are prefixed with the
+// function's number (_1_x, _2_x, ...) to keep their scopes apart and their labels are
+// renumbered to follow one another. A file with one function is written exactly as before.
+// Execution starts with the first function.
+//
+static void write_assembly(code_buffer &output, const translation_unit &unit)
+{
+  bool several = unit.functions.size() > 1;
+  std::vector<std::string> prefixes;
+  for (std::size_t i = 0; i < unit.functions.size(); ++i) {
+    prefixes.push_back(several ? std::to_string(i + 1) + "_" : std::string());
+  }
+
+  // Send the boilerplate.
+  output << "; Code generated by vocal compiler." << '\n';
+  output << "    ORG 0x0000" << '\n';
+  output << "    jmp @code_start" << '\n';
+  for (std::size_t i = 0; i < unit.functions.size(); ++i) {
+    write_variables(output, unit.functions[i]->symbols, prefixes[i].c_str());
+  }
+  // Put any initialization code here.
+  output << "@code_start:" << '\n'
+         << "    ; Set up the stack pointer." << '\n'
+         << "    copy 0x8000, r7" << '\n';
+
+  int label_base = 0;
+  int removed    = 0;
+  for (std::size_t i = 0; i < unit.functions.size(); ++i) {
+    const function_unit &function = *unit.functions[i];
+    if (several) output << "; Function " << function.name << '\n';
+    function.code->write(output, label_base, prefixes[i].c_str());
+    label_base += function.label_count;
+    removed    += function.removed;
+  }
+  output << "; Peephole optimizer removed " << removed << " instructions." << '\n';
+}
+
+
+// Writes the output file of a translation unit, as assembly language or as an object file.
+static void write_file(translation_unit &unit)
+{
+  pass_timer timing(OUTPUT_PASS);
+  code_buffer output;
+  if (!output.open(unit.output_name.c_str())) {
+    unit.messages << "Error opening " << unit.output_name << "!!!" << '\n';
+    unit.status = 2;
+    return;
+  }
+
+  if (emit_object) write_object(output, unit);
+  else write_assembly(output, unit);
+
+  // The code is no longer needed.
+  for (std::size_t i = 0; i < unit.functions.size(); ++i) {
+    delete unit.functions[i]->code;
+    unit.functions[i]->code = 0;
+  }
+
+  if (stats) stats->bytes += output.bytes_generated();
+  if (!output.close()) {
+    unit.messages << "Error writing " << unit.output_name << "!!!" << '\n';
+    unit.status = 2;
+    return;
+  }
+
+  // Only clean compilations are cached so that warnings are repeated every time the file is
+  // compiled.
+  if (!unit.cache_key.empty()) {
+    for (std::size_t i = 0; i < unit.functions.size(); ++i) {
+      if (unit.functions[i]->messages.tellp() != 0) return;
+    }
+    pass_timer caching(CACHE_PASS);
+    cache.store(unit.cache_key, unit.output_name);
+  }
+}
+
+
+// Runs one phase of the compilation on the pool, timing it and collecting the statistics of
+// each job in the given place.
+//
+template<typename unit_type>
+static void run_phase(thread_pool &pool,
+                      phase_type phase,
+                      statistics &totals,
+                      const std::vector<unit_type *> &units,
+                      void (*job)(unit_type &))
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  pool.run(units.size(), [&](std::size_t i) {
+    stats = collecting ? &units[i]->measurements : 0;
+    job(*units[i]);
+    stats = 0;
+  });
+  totals.phase_time[phase] = nanoseconds_since(start);
+}
 
-extern int yyparse();
-extern FILE *yyin;
 
 int main(int argc, char **argv)
 {
- 
-  if (argc == 1) {
-    std::cout << "Usage: " << argv[0] << " filename.vcl" << std::endl;
-  }
-  else {
-    // Assume the second command line argument is the filename.
-    if (!(yyin = fopen(argv[1], "r"))) {
-      std::cout << "Error opening " << argv[1] << "!!!" << std::endl;
-      return 1;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  // The number of threads defaults to the number of processors.
+  int thread_count = static_cast<int>(std::thread::hardware_concurrency());
+  const char *cache_directory = 0;
+  bool time_passes = false;
+  bool json_stats  = false;
+  std::vector<translation_unit *> units;
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      thread_count = std::atoi(argv[++i]);
+      continue;
+    }
+    if (std::strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc) {
+      cache_directory = argv[++i];
+      continue;
+    }
+    if (std::strncmp(argv[i], "--cache-dir=", 12) == 0) {
+      cache_directory = argv[i] + 12;
+      continue;
+    }
+    if (std::strcmp(argv[i], "--time-passes") == 0 || std::strcmp(argv[i], "--stats=text") == 0) {
+      time_passes = true;
+      continue;
+    }
+    if (std::strcmp(argv[i], "--stats=json") == 0) {
+      json_stats = true;
+      continue;
     }
-    yyparse();
-    // Try to open the output file.
-    std::string output_filename(argv[1]);
+    if (std::strcmp(argv[i], "--emit=oj") == 0 || std::strcmp(argv[i], "--emit=vas") == 0) {
+      emit_object = std::strcmp(argv[i], "--emit=oj") == 0;
+      continue;
+    }
+    translation_unit *unit = new translation_unit;
+    unit->source_name = argv[i];
+    units.push_back(unit);
+  }
+  if (units.empty()) {
+    std::cout << "Usage: " << argv[0] << " [-j threads] [--cache-dir directory]"
+              << " [--time-passes] [--stats=json] [--emit=oj] filename.vcl ..." << std::endl;
+    return 0;
+  }
+  collecting = time_passes || json_stats;
+
+  // The output file has the name of the source file with a .vas (or .oj) extension instead of
+  // .vcl.
+  for (std::size_t i = 0; i < units.size(); ++i) {
+    std::string output_filename(units[i]->source_name);
     // Get rid of the vcl extension, if we can find it.
     int ext_location = output_filename.find(".vcl");
     if (ext_location > 0) {
       output_filename.erase(ext_location, output_filename.length() - ext_location);
     }
-    output_filename += ".vas";
-    output.open(output_filename.c_str());
-    if (output.bad()) {
-      std::cout << "Error opening " << output_filename << "!!!" << std::endl;
-      return 2;
+    output_filename += emit_object ? ".oj" : ".vas";
+    units[i]->output_name = output_filename;
+  }
+  if (thread_count < 1) thread_count = 1;
+  if (cache_directory != 0 &&
+      !cache.open(cache_directory, compiler_identity(), emit_object ? "emit=oj" : "")) {
+    std::cout << "Can't use cache directory " << cache_directory << "; not caching." << std::endl;
+  }
+
+  thread_pool pool(thread_count);
+  statistics  totals;
+
+  // Parse every file (or find its output in the cache).
+  run_phase(pool, PARSE_PHASE, totals, units, parse_file);
+
+  // Compile every function of every file that parsed.
+  std::vector<function_unit *> functions;
+  for (std::size_t i = 0; i < units.size(); ++i) {
+    if (units[i]->status != 0) continue;
+    functions.insert(functions.end(), units[i]->functions.begin(), units[i]->functions.end());
+  }
+  run_phase(pool, COMPILE_PHASE, totals, functions, compile_function);
+
+  // A file with a function that had errors fails and isn't written.
+  for (std::size_t i = 0; i < units.size(); ++i) {
+    for (std::size_t j = 0; j < units[i]->functions.size(); ++j) {
+      if (units[i]->functions[j]->errors != 0) units[i]->status = 1;
     }
+  }
 
-    // If we get here, the input file has been parsed and the output file
-    // has been opened.  
-    
-    // Send the boilerplate.
-    output << "; Code generated by vocal compiler." << std::endl;
-    output << "    ORG 0x0000" << std::endl;
-    output << "    jmp @code_start" << std::endl;
-    // Generate locations for variables.
-    for (std::map<std::string, symbol_attrs>::iterator myit = symbol_table.begin(); 
-	 myit != symbol_table.end(); myit++) {
-
-      // See how much storage we need for this type.
-      switch(myit->second.vartype) {
-      case tINT:
-	// Ints only need one word.
-	output << "_" << myit->first << ": DW 0" << std::endl;
-	break;
-      case tLONG:
-	// Longs need two words.
-	output << "_" << myit->first << ": DW 0" << std::endl
-	       << "    DW 0" << std::endl;
-	break;
-      case tINTARRAY:
-	// An array of ints needs one word per element.
-	// Assuming there is at least 1 element.
-	output << "_" << myit->first << ": DW 0" << std::endl;
-	for (int i = 1; i < myit->second.num_elements; ++i) {
-	  output << "    DW 0" << std::endl;
-	}
-	break;
-      case tLONGARRAY:
-	// An array of longs needs two words per element.
-	// Assuming there is at least 1 element.
-	output << "_" << myit->first << ": DW 0" << std::endl
-	       << "    DW 0" << std::endl;
-	for (int i = 1; i < myit->second.num_elements; ++i) {
-	  output << "    DW 0" << std::endl
-		 << "    DW 0" << std::endl;
-	}
-	break;
-      default:
-	std::cerr << "ERROR: " << myit->first << " has unknown type!\n" << std::endl;
-      }
+  // Write every file that compiled.
+  std::vector<translation_unit *> finished;
+  for (std::size_t i = 0; i < units.size(); ++i) {
+    if (units[i]->status == 0 && !units[i]->cached) finished.push_back(units[i]);
+  }
+  run_phase(pool, WRITE_PHASE, totals, finished, write_file);
 
+  // Report what happened in the order the files were given, whatever order the work was done
+  // in. The exit status is the worst of the files' statuses.
+  int status = 0;
+  for (std::size_t i = 0; i < units.size(); ++i) {
+    translation_unit &unit = *units[i];
+    std::string warnings;
+    for (std::size_t j = 0; j < unit.functions.size(); ++j) {
+      warnings += unit.functions[j]->messages.str();
+      totals.add(unit.functions[j]->measurements);
     }
-    // Put any initialization code here.
-    output << "@code_start:" << std::endl
-           << "    ; Set up the stack pointer." << std::endl
-	   << "    copy 0x8000, r7" << std::endl;
-    // Make the assembly.
-    root_node->generate();
-    output.close();
-    fclose(yyin);
-  }
-  
-  return 0;
+    totals.add(unit.measurements);
+    std::string messages = unit.messages.str();
+    // The messages don't name the file so say which one they are about.
+    if (units.size() > 1 && !warnings.empty()) std::cerr << unit.source_name << ":\n";
+    std::cerr << warnings;
+    if (units.size() > 1 && !messages.empty()) std::cout << unit.source_name << ":\n";
+    std::cout << messages << std::flush;
+    status = std::max(status, unit.status);
+    delete units[i];
+  }
+
+  totals.phase_time[TOTAL_PHASE] = nanoseconds_since(start);
+  if (time_passes) totals.write_text(std::cerr);
+  if (json_stats) totals.write_json(std::cout);
+  return status;
 }
@@ -14,671 +14,629 @@ Please send comments or bug reports to
 #include "node-types.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <iostream>
-#include <fstream>
 
 using namespace std;
 
-extern ofstream output;
+thread_local ostream *diagnostics = &cerr;
+thread_local int     *error_count = 0;
 
-// Declaring the symbol table.
-extern std::map<std::string, symbol_attrs> symbol_table;
+
+// Returns the stream to write an error message to and counts the error.
+static ostream &error_message()
+{
+  if (error_count != 0) ++*error_count;
+  return *diagnostics;
+}
 
 
-// This just returns a new label every time.
-string next_label()
+//
+// Helper functions for expression evaluation
+//
+
+static int width(symbol_type t)
 {
-  static int labelnum = 0;
-  // I'm generating the label in a C-style string and then returning it in a std::string.
-  char label[10];
-  sprintf(label, "_L%06d", labelnum++);
-  string retval(label);
-  return retval;
+  return t == tLONG ? 2 : 1;
 }
 
-symbol_type and_node::generate()
+
+//
+// Helper functions for constant folding
+//
+
+// Returns an annotated constant node.
+static expr_node *constant(unsigned long value, symbol_type t, int line)
 {
-  string label1 = next_label();
-  string label2 = next_label();
+  expr_node *result = new num_node(static_cast<int>(value & value_mask(t)), t, line);
+  result->annotate();
+  return result;
+}
 
-  // Generate the left and right expressions first.
-  symbol_type t_left  = left->generate();
-  symbol_type t_right = right->generate();
+// Returns n if the value is 2 to the n. Otherwise returns -1.
+static int power_of_two(unsigned long value)
+{
+  if (value == 0 || (value & (value - 1)) != 0) return -1;
 
-  if (t_left == tERROR || t_right == tERROR) {
-    return tERROR;
+  int n = 0;
+  while (value > 1) {
+    value >>= 1;
+    ++n;
   }
+  return n;
+}
+
+// Returns an annotated node that shifts an int expression.
+static expr_node *shift(expr_node *e, shift_type direction, int count, int line)
+{
+  expr_node *result = new shift_node(e, direction, count, line);
+  result->annotate();
+  return result;
+}
 
-  // Because we are expecting 0's and 1's on the stack from the relational nodes, having LONGs
-  // there is an error.
+
+//
+// Class binary_node
+//
+
+void binary_node::order_operands(int left_need, int left_held, int right_need, int right_held)
+{
+  int left_first_need  = max(left_need, left_held + right_need);
+  int right_first_need = max(right_need, right_held + left_need);
+
+  right_first = right_first_need < left_first_need;
+  need = right_first ? right_first_need : left_first_need;
+}
+
+void binary_node::bind()
+{
+  left->bind();
+  right->bind();
+}
+
+expr_node *binary_node::simplify()
+{
+  left  = left->simplify();
+  right = right->simplify();
+  annotate();
+  return fold();
+}
+
+// Generates both operands in the order chosen by annotate(). Their temporaries are computed in
+// that order, which is the order instruction selection gives them registers. Both are generated
+// even if one of them has an error so that all the errors are reported.
+//
+void binary_node::generate_operands
+  (symbol_type &t_left, ir_operand &l, symbol_type &t_right, ir_operand &r)
+{
+  if (right_first) {
+    t_right = right->generate(r);
+    t_left  = left->generate(l);
+  }
+  else {
+    t_left  = left->generate(l);
+    t_right = right->generate(r);
+  }
+}
+
+
+// The boolean operators. Any nonzero operand is true and the result is 0 or 1. When used as the
+// condition of a statement they are generated as branches instead (see generate_branch()) and
+// the right operand is only evaluated if it is needed.
+//
+void and_node::annotate()
+{
+  result_type = tINT;
+  order_operands(max(left->registers_needed(), 1), 1,
+                 right->registers_needed(), right->registers_held());
+}
+
+expr_node *and_node::fold()
+{
+  unsigned long l, r;
+  if (left->expression_type() == tINT && left->is_constant(l) &&
+      right->expression_type() == tINT && right->is_constant(r)) {
+    return constant(l != 0 && r != 0, tINT, line_number);
+  }
+  return this;
+}
+
+symbol_type and_node::generate(ir_operand &result)
+{
+  ir_operand l, r;
+  symbol_type t_left, t_right;
+  generate_operands(t_left, l, t_right, r);
+
+  if (t_left == tERROR || t_right == tERROR) return tERROR;
+
+  // Because we are expecting 0's and 1's from the relational nodes, having LONGs there is an
+  // error.
   //
   if (t_left != tINT || t_right != tINT) {
-    cerr << "ERROR - LONG type used in AND expression on line " 
+    error_message() << "ERROR - LONG type used in AND expression on line "
 	 << line_number << endl;
     return tERROR;
   }
 
-  // Because I am planning on having all relational nodes leave either a 0 or 1 on the stack as
-  // their result, I should be able to get away with using logical AND for my boolean AND.
-  //
-  output << "    pop r1" << endl
-	 << "    pop r0" << endl
-	 << "    and r1, r0" << endl
-	 << "    jz " << label1 << endl
-	 << "    push 1" << endl
-	 << "    jmp " << label2 << endl
-	 << label1 << ":" << endl
-	 << "    push 0" << endl
-	 << label2 << ":" << endl;
+  result = ir->compute(IR_AND, tINT, l, r);
   return tINT;
 }
 
-symbol_type or_node::generate()
+// Goes to if_false as soon as either operand is false. The right operand is skipped when the
+// left decides the outcome.
+//
+void and_node::generate_branch(int if_true, int if_false)
 {
-  string label1 = next_label();
-  string label2 = next_label();
+  if (left->expression_type() == tLONG || right->expression_type() == tLONG) {
+    error_message() << "ERROR - LONG type used in AND expression on line "
+	 << line_number << endl;
+    return;
+  }
 
-  // Generate the left and right expressions first.
-  symbol_type t_left  = left->generate();
-  symbol_type t_right = right->generate();
+  int right_block = ir->new_block();
+  left->generate_branch(right_block, if_false);
+  ir->start(right_block);
+  right->generate_branch(if_true, if_false);
+}
 
-  if (t_left == tERROR || t_right == tERROR) {
-    return tERROR;
+void or_node::annotate()
+{
+  result_type = tINT;
+  order_operands(max(left->registers_needed(), 1), 1,
+                 right->registers_needed(), right->registers_held());
+}
+
+expr_node *or_node::fold()
+{
+  unsigned long l, r;
+  if (left->expression_type() == tINT && left->is_constant(l) &&
+      right->expression_type() == tINT && right->is_constant(r)) {
+    return constant((l | r) != 0, tINT, line_number);
   }
+  return this;
+}
+
+symbol_type or_node::generate(ir_operand &result)
+{
+  ir_operand l, r;
+  symbol_type t_left, t_right;
+  generate_operands(t_left, l, t_right, r);
+
+  if (t_left == tERROR || t_right == tERROR) return tERROR;
 
-  // Because we are expecting 0's and 1's on the stack from the relational nodes, having LONGs
-  // there is an error.
+  // Because we are expecting 0's and 1's from the relational nodes, having LONGs there is an
+  // error.
   //
   if (t_left != tINT || t_right != tINT) {
-    cerr << "ERROR - LONG type used in AND expression on line " 
+    error_message() << "ERROR - LONG type used in OR expression on line "
 	 << line_number << endl;
     return tERROR;
   }
 
-  // Because I am planning on having all relational nodes leave either a 0 or 1 on the stack as
-  // their result, I should be able to get away with using logical OR for my boolean OR.
-  //
-  output << "    pop r1" << endl
-	 << "    pop r0" << endl
-	 << "    or r1, r0" << endl
-	 << "    jz " << label1 << endl
-	 << "    push 1" << endl
-	 << "    jmp " << label2 << endl
-	 << label1 << ":" << endl
-	 << "    push 0" << endl
-	 << label2 << ":" << endl;
+  result = ir->compute(IR_OR, tINT, l, r);
   return tINT;
 }
 
-symbol_type relational_node::generate()
+// Goes to if_true as soon as either operand is true. The right operand is skipped when the left
+// decides the outcome.
+//
+void or_node::generate_branch(int if_true, int if_false)
 {
-  string lblTrue = next_label();
-  string lblFalse = next_label();
-  string lblDone = next_label();
-  string lblNext; 
-  // Generate the left and right expressions first.
-  symbol_type t_left  = left->generate();
-  symbol_type t_right = right->generate();
-
-  if (t_left == tERROR || t_right == tERROR) {
-    return tERROR;
+  if (left->expression_type() == tLONG || right->expression_type() == tLONG) {
+    error_message() << "ERROR - LONG type used in OR expression on line "
+	 << line_number << endl;
+    return;
   }
 
-  // What a mess this is. Convert the tINT to a tLONG for mismatched types.
+  int right_block = ir->new_block();
+  left->generate_branch(if_true, right_block);
+  ir->start(right_block);
+  right->generate_branch(if_true, if_false);
+}
 
-  // Right is on top of the stack, so it's easiest to convert.
-  if (t_right == tINT && t_left == tLONG) {
-    // Take it off the stack and push a 0 as the MSW.
-    output << "    pop r0" << endl
-	   << "    push 0" << endl
-	   << "    push r0" << endl;
-    t_right = tLONG;
-  }
-  else if (t_left == tINT && t_right == tLONG) {
-    // This is a little more complicated. The INT is underneath the LONG. Pop both off the stack
-    // and then put a 0 in for the LSW of the INT.
-    //
-    output << "    pop r2" << endl
-	   << "    pop r1" << endl
-	   << "    pop r0" << endl
-	   << "    push 0" << endl
-	   << "    push r0" << endl
-	   << "    push r1" << endl
-	   << "    push r2" << endl;
-    t_left = tLONG;
-  }    
 
+void relational_node::annotate()
+{
+  result_type = tINT;
+  order_operands(left->registers_needed(), left->registers_held(),
+                 right->registers_needed(), right->registers_held());
+  need = max(need, 1);
+}
 
+// Comparisons are unsigned. An int compared with a long is widened with a zero MSW, which is
+// what its value already is.
+//
+expr_node *relational_node::fold()
+{
+  unsigned long l, r;
+  if (!left->is_constant(l) || !right->is_constant(r)) return this;
+
+  bool outcome = false;
   switch (type) {
-  case EQ_TYPE:
-    if(t_left == tINT && t_right == tINT) {
-      output << "    pop r1" << endl
-	     << "    pop r0" << endl
-	     << "    cmp r1, r0" << endl
-	     << "    jnz " << lblFalse << endl
-	     << "    push 1" << endl
-	     << "    jmp " << lblDone << endl
-	     << lblFalse << ":" << endl
-	     << "    push 0" << endl
-	     << lblDone << ":" << endl;
-    }
-    else if(t_left == tLONG && t_right == tLONG) {
-      // Hmm... pop both longs off the stack (LSW first) and compare one word at a time.
-      output << "    pop r0" << endl << "    pop r1" << endl
-	     << "    pop r2" << endl << "    pop r3" << endl
-	     << "    cmp r3, r1" << endl // Check the MSW first.
-	     << "    jnz " << lblFalse << endl
-	     << "    cmp r2, r0" << endl // Check the LSW next.
-	     << "    jnz " << lblFalse << endl
-	     << "    push 1" << endl // They were both equal!
-	     << "    jmp " << lblDone << endl
-	     << lblFalse << ":" << endl
-	     << "    push 0" << endl // One of the words was not equal.
-	     << lblDone << ":" << endl;
-    }
-    else {
-      cerr << "Error in comparison between INT and LONG on line"
-	   << line_number << endl;
-    }
-    break;
-
-  case NE_TYPE:
-    if(t_left == tINT && t_right == tINT) {
-      output << "    pop r1" << endl
-	     << "    pop r0" << endl
-	     << "    cmp r1, r0" << endl
-	     << "    jz " << lblFalse << endl
-	     << "    push 1" << endl
-	     << "    jmp " << lblDone << endl
-	     << lblFalse << ":" << endl
-	     << "    push 0" << endl
-	     << lblDone << ":" << endl;
-    }
-    else if(t_left == tLONG && t_right == tLONG) {
-      // Hmm...  pop both longs off the stack (LSW first) and compare
-      // one word at a time.
-      output << "    pop r0" << endl << "    pop r1" << endl
-	     << "    pop r2" << endl << "    pop r3" << endl
-	     << "    cmp r3, r1" << endl // Check the MSW first.
-	     << "    jnz " << lblTrue << endl
-	     << "    cmp r2, r0" << endl // Check the LSW next.
-	     << "    jz " << lblFalse << endl
-	     << lblTrue << ":" << endl
-	     << "    push 1" << endl // They were both equal!
-	     << "    jmp " << lblDone << endl
-	     << lblFalse << ":" << endl
-	     << "    push 0" << endl // One of the words was not equal.
-	     << lblDone << ":" << endl;
-    }
-    else {
-      cerr << "Error in comparison between INT and LONG on line"
-	   << line_number << endl;
-    }
+  case EQ_TYPE: outcome = (l == r); break;
+  case NE_TYPE: outcome = (l != r); break;
+  case LT_TYPE: outcome = (l <  r); break;
+  case GT_TYPE: outcome = (l >  r); break;
+  case LE_TYPE: outcome = (l <= r); break;
+  case GE_TYPE: outcome = (l >= r); break;
+  }
+  return constant(outcome, tINT, line_number);
+}
 
-    break;
-
-  case LT_TYPE:
-    if(t_left == tINT && t_right == tINT) {
-      output << "    pop r1" << endl
-	     << "    pop r0" << endl
-	     << "    cmp r1, r0" << endl
-	     << "    jz " << lblFalse << endl
-	     << "    jnc " << lblFalse << endl
-	     << "    push 1" << endl
-	     << "    jmp " << lblDone << endl
-	     << lblFalse << ":" << endl
-	     << "    push 0" << endl
-	     << lblDone << ":" << endl;
-    }
-    else if(t_left == tLONG && t_right == tLONG) {
-      // We're going to need an extra label to make this work out right.
-      lblNext = next_label();
-      output << "    pop r3" << endl << "    pop r2" << endl
-	     << "    pop r1" << endl << "    pop r0" << endl
-	     << "    cmp r3, r1" << endl // Check the MSWs
-	     << "    jz " << lblNext << endl // Equal - check LSWs
-	     << "    jnc " << lblFalse << endl
-	     << "    jmp " << lblTrue << endl
-	     << lblNext << ":" << endl
-	     << "    cmp r2, r0" << endl
-	     << "    jz " << lblFalse << endl
-	     << "    jnc " << lblFalse << endl
-	     << lblTrue << ":" << endl
-	     << "    push 1" << endl
-	     << "    jmp " << lblDone << endl
-	     << lblFalse << ":" << endl
-	     << "    push 0" << endl
-	     << lblDone << ":" << endl;
-    }
-    else {
-      cerr << "Error in comparison between INT and LONG on line"
-	   << line_number << endl;
-    }
+symbol_type relational_node::generate(ir_operand &result)
+{
+  ir_operand l, r;
+  symbol_type t_left, t_right;
+  generate_operands(t_left, l, t_right, r);
 
-    break;
-
-  case GT_TYPE:
-    if(t_left == tINT && t_right == tINT) {
-      output << "    pop r1" << endl
-	     << "    pop r0" << endl
-	     << "    cmp r0, r1" << endl
-	     << "    jz " << lblFalse << endl
-	     << "    jnc " << lblFalse << endl
-	     << "    push 1" << endl
-	     << "    jmp " << lblDone << endl
-	     << lblFalse << ":" << endl
-	     << "    push 0" << endl
-	     << lblDone << ":" << endl;
-    }
-    else if(t_left == tLONG && t_right == tLONG) {
-      // We're going to need an extra label to make this work out right.
-      lblNext = next_label();
-      output << "    pop r3" << endl << "    pop r2" << endl
-	     << "    pop r1" << endl << "    pop r0" << endl
-	     << "    cmp r1, r3" << endl // Check the MSWs
-	     << "    jz " << lblNext << endl // Equal - check LSWs
-	     << "    jnc " << lblFalse << endl
-	     << "    jmp " << lblTrue << endl
-	     << lblNext << ":" << endl
-	     << "    cmp r0, r2" << endl
-	     << "    jz " << lblFalse << endl
-	     << "    jnc " << lblFalse << endl
-	     << lblTrue << ":" << endl
-	     << "    push 1" << endl
-	     << "    jmp " << lblDone << endl
-	     << lblFalse << ":" << endl
-	     << "    push 0" << endl
-	     << lblDone << ":" << endl;
-    }
-    else {
-      cerr << "Error in comparison between INT and LONG on line"
-	   << line_number << endl;
-    }
+  if (t_left == tERROR || t_right == tERROR) return tERROR;
 
-    break;
-
-    // LE is just the inverse of GT.
-  case LE_TYPE:
-    if(t_left == tINT && t_right == tINT) {
-      output << "    pop r1" << endl
-	     << "    pop r0" << endl
-	     << "    cmp r1, r0" << endl
-	     << "    jz " << lblTrue << endl
-	     << "    jnc " << lblFalse << endl
-	     << lblTrue << ":" << endl
-	     << "    push 1" << endl
-	     << "    jmp " << lblDone << endl
-	     << lblFalse << ":" << endl
-	     << "    push 0" << endl
-	     << lblDone << ":" << endl;
-    }
-    else if(t_left == tLONG && t_right == tLONG) {
-      // We're going to need an extra label to make this work out right.
-      lblNext = next_label();
-      output << "    pop r3" << endl << "    pop r2" << endl
-	     << "    pop r1" << endl << "    pop r0" << endl
-	     << "    cmp r3, r1" << endl // Check the MSWs
-	     << "    jz " << lblNext << endl // Equal - check LSWs
-	     << "    jnc " << lblFalse << endl
-	     << "    jmp " << lblTrue << endl
-	     << lblNext << ":" << endl
-	     << "    cmp r2, r0" << endl
-	     << "    jz " << lblTrue << endl
-	     << "    jnc " << lblFalse << endl
-	     << lblTrue << ":" << endl
-	     << "    push 1" << endl
-	     << "    jmp " << lblDone << endl
-	     << lblFalse << ":" << endl
-	     << "    push 0" << endl
-	     << lblDone << ":" << endl;
-    }
-    else {
-      cerr << "Error in comparison between INT and LONG on line"
-	   << line_number << endl;
-    }
+  result = ir->compare(type, l, r);
+  return tINT;
+}
 
-    break;
-
-    // GE is just the inverse of LT.
-  case GE_TYPE:
-    if(t_left == tINT && t_right == tINT) {
-      output << "    pop r1" << endl
-	     << "    pop r0" << endl
-	     << "    cmp r0, r1" << endl
-	     << "    jz " << lblTrue << endl
-	     << "    jnc " << lblFalse << endl
-	     << lblTrue << ":" << endl
-	     << "    push 1" << endl
-	     << "    jmp " << lblDone << endl
-	     << lblFalse << ":" << endl
-	     << "    push 0" << endl
-	     << lblDone << ":" << endl;
-    }
-    else if(t_left == tLONG && t_right == tLONG) {
-      // We're going to need an extra label to make this work out right.
-      lblNext = next_label();
-      output << "    pop r3" << endl << "    pop r2" << endl
-	     << "    pop r1" << endl << "    pop r0" << endl
-	     << "    cmp r1, r3" << endl // Check the MSWs
-	     << "    jz " << lblNext << endl // Equal - check LSWs
-	     << "    jnc " << lblFalse << endl
-	     << "    jmp " << lblTrue << endl
-	     << lblNext << ":" << endl
-	     << "    cmp r0, r2" << endl
-	     << "    jz " << lblTrue << endl
-	     << "    jnc " << lblFalse << endl
-	     << lblTrue << ":" << endl
-	     << "    push 1" << endl
-	     << "    jmp " << lblDone << endl
-	     << lblFalse << ":" << endl
-	     << "    push 0" << endl
-	     << lblDone << ":" << endl;
-    }
-    else {
-      cerr << "Error in comparison between INT and LONG on line"
-	   << line_number << endl;
-      return tERROR;
-    }
+// A comparison used as a condition branches directly on its outcome.
+void relational_node::generate_branch(int if_true, int if_false)
+{
+  ir_operand l, r;
+  symbol_type t_left, t_right;
+  generate_operands(t_left, l, t_right, r);
 
-    break;
-  }
-  return t_right;
+  if (t_left == tERROR || t_right == tERROR) return;
+
+  ir->branch(type, l, r, if_true, if_false);
 }
 
-symbol_type add_node::generate()
+
+// The type of a sum or difference. Mixing an INT with a LONG gives a LONG.
+static symbol_type arithmetic_type(symbol_type t_left, symbol_type t_right)
 {
-  // Generate the left and right expressions first.
-  symbol_type t_left  = left->generate();
-  symbol_type t_right = right->generate();
+  if (t_left == tERROR || t_right == tERROR) return tERROR;
+  return (t_left == tLONG || t_right == tLONG) ? tLONG : tINT;
+}
 
-  if (t_left == tERROR || t_right == tERROR) {
-    return tERROR;
-  }
-  // What a mess this is. Convert the tINT to a tLONG for mismatched types.
-
-  // Right is on top of the stack, so it's easiest to convert.
-  if (t_right == tINT && t_left == tLONG) {
-    // Take it off the stack and push a 0 as the MSW.
-    output << "    pop r0" << endl
-	   << "    push 0" << endl
-	   << "    push r0" << endl;
-    t_right = tLONG;
-  }
-  else if (t_left == tINT && t_right == tLONG) {
-    // This is a little more complicated. The INT is underneath the LONG. Pop both off the stack
-    // and then put a 0 in for the LSW of the INT.
-    //
-    output << "    pop r2" << endl
-	   << "    pop r1" << endl
-	   << "    pop r0" << endl
-	   << "    push 0" << endl
-	   << "    push r0" << endl
-	   << "    push r1" << endl
-	   << "    push r2" << endl;
-    t_left = tLONG;
-  }    
-  
-  if(t_left == tINT && t_right == tINT) {
-    output << "    pop r1" << endl
-	   << "    pop r0" << endl
-	   << "    clc" << endl 
-	   << "    add r1, r0" << endl
-	   << "    push r0" << endl;
-    return tINT;
-  }
-  else if (t_left == tLONG && t_right == tLONG) {
-    output << "    pop r0" << endl // LSW comes off stack first.
-	   << "    pop r1" << endl
-	   << "    pop r2" << endl
-	   << "    pop r3" << endl
-	   << "    clc" << endl 
-	   << "    add r2, r0" << endl // Add without carry.
-	   << "    add r3, r1" << endl // Add with carry.
-	   << "    push r1" << endl // Push result MSW first.
-	   << "    push r0" << endl;
-    return tLONG;
+void add_node::annotate()
+{
+  result_type = arithmetic_type(left->expression_type(), right->expression_type());
+  int w = width(result_type);
+  order_operands(max(left->registers_needed(), w), w,
+                 right->registers_needed(), right->registers_held());
+}
+
+// Adding zero is only removed if that doesn't change the type of the result. An int plus a
+// long zero is still a long.
+//
+expr_node *add_node::fold()
+{
+  unsigned long l, r;
+  bool l_constant = left->is_constant(l);
+  bool r_constant = right->is_constant(r);
+
+  if (result_type == tERROR) return this;
+  if (l_constant && r_constant) return constant(l + r, result_type, line_number);
+  if (r_constant && r == 0 && left->expression_type() == result_type) return left;
+  if (l_constant && l == 0 && right->expression_type() == result_type) return right;
+  return this;
+}
+
+symbol_type add_node::generate(ir_operand &result)
+{
+  ir_operand l, r;
+  symbol_type t_left, t_right;
+  generate_operands(t_left, l, t_right, r);
+
+  symbol_type t_result = arithmetic_type(t_left, t_right);
+  if (t_result == tERROR) return tERROR;
+
+  result = ir->compute(IR_ADD, t_result, l, r);
+  return t_result;
+}
+
+void sub_node::annotate()
+{
+  result_type = arithmetic_type(left->expression_type(), right->expression_type());
+  int w = width(result_type);
+  order_operands(max(left->registers_needed(), w), w,
+                 right->registers_needed(), right->registers_held());
+}
+
+expr_node *sub_node::fold()
+{
+  unsigned long l, r;
+  bool l_constant = left->is_constant(l);
+  bool r_constant = right->is_constant(r);
+
+  if (result_type == tERROR) return this;
+  if (l_constant && r_constant) return constant(l - r, result_type, line_number);
+  if (r_constant && r == 0 && left->expression_type() == result_type) return left;
+  return this;
+}
+
+symbol_type sub_node::generate(ir_operand &result)
+{
+  ir_operand l, r;
+  symbol_type t_left, t_right;
+  generate_operands(t_left, l, t_right, r);
+
+  symbol_type t_result = arithmetic_type(t_left, t_right);
+  if (t_result == tERROR) return tERROR;
+
+  result = ir->compute(IR_SUB, t_result, l, r);
+  return t_result;
+}
+
+void mul_node::annotate()
+{
+  result_type = arithmetic_type(left->expression_type(), right->expression_type());
+  order_operands(left->registers_needed(), left->registers_held(),
+                 right->registers_needed(), right->registers_held());
+
+  // The multiplicand and the product are both the width of the result. A constant multiplier
+  // doesn't need a register. Otherwise it keeps its own width.
+  //
+  int w = width(result_type);
+  unsigned long value;
+  if (left->is_constant(value) || right->is_constant(value)) {
+    need = max(need, 2 * w);
   }
   else {
-    cerr << "Error in addition between INT and LONG on line"
-	 << line_number << endl;
-    return tERROR;
+    bool narrow = left->expression_type() == tINT || right->expression_type() == tINT;
+    need = max(need, 2 * w + (narrow ? 1 : w));
   }
-  
 }
 
-symbol_type sub_node::generate()
+// A long product only keeps the low 32 bits, like an int product keeps the low 16.
+expr_node *mul_node::fold()
 {
-  // Generate the left and right expressions first.
-  symbol_type t_left  = left->generate();
-  symbol_type t_right = right->generate();
+  if (result_type == tERROR) return this;
 
-  if (t_left == tERROR || t_right == tERROR) {
-    return tERROR;
-  }
-  // What a mess this is. Convert the tINT to a tLONG for mismatched types.
-
-  // Right is on top of the stack, so it's easiest to convert.
-  if (t_right == tINT && t_left == tLONG) {
-    // Take it off the stack and push a 0 as the MSW.
-    output << "    pop r0" << endl
-	   << "    push 0" << endl
-	   << "    push r0" << endl;
-    t_right = tLONG;
-  }
-  else if (t_left == tINT && t_right == tLONG) {
-    // This is a little more complicated. The INT is underneath the LONG. Pop both off the stack
-    // and then put a 0 in for the LSW of the INT.
-    //
-    output << "    pop r2" << endl
-	   << "    pop r1" << endl
-	   << "    pop r0" << endl
-	   << "    push 0" << endl
-	   << "    push r0" << endl
-	   << "    push r1" << endl
-	   << "    push r2" << endl;
-    t_left = tLONG;
-  }    
-  
-  if(t_left == tINT && t_right == tINT) {
-    output << "    pop r1" << endl
-	   << "    pop r0" << endl
-	   << "    clc" << endl 
-	   << "    sub r1, r0" << endl
-	   << "    push r0" << endl;
-    return tINT;
-  }
-  else if (t_left == tLONG && t_right == tLONG) {
-    output << "    pop r0" << endl // LSW comes off stack first.
-	   << "    pop r1" << endl
-	   << "    pop r2" << endl
-	   << "    pop r3" << endl
-	   << "    clc" << endl 
-	   << "    sub r0, r2" << endl // Sub without carry.
-	   << "    sub r1, r3" << endl // Sub with carry (borrow).
-	   << "    push r3" << endl // Push result MSW first.
-	   << "    push r2" << endl;
-    return tLONG;
+  unsigned long l, r;
+  bool l_constant = left->is_constant(l);
+  bool r_constant = right->is_constant(r);
+
+  if (l_constant && r_constant) return constant(l * r, result_type, line_number);
+
+  // Put the constant on the right.
+  expr_node *other = left;
+  if (l_constant) {
+    other = right;
+    r = l;
   }
-  else {
-    cerr << "Error in subtraction between INT and LONG on line"
-	 << line_number << endl;
-    return tERROR;
+  else if (!r_constant) {
+    return this;
   }
 
+  if (r == 0) return constant(0, result_type, line_number);
+  if (other->expression_type() != result_type) return this;
+  if (r == 1) return other;
+  int n = power_of_two(r);
+  if (n > 0 && result_type == tINT) return shift(other, SHIFT_LEFT, n, line_number);
+  return this;
 }
 
-symbol_type mul_node::generate()
+symbol_type mul_node::generate(ir_operand &result)
 {
-  string label1 = next_label();
-  string label2 = next_label();
+  ir_operand l, r;
+  symbol_type t_left, t_right;
+  generate_operands(t_left, l, t_right, r);
 
-  // Generate the left and right expressions first.
-  symbol_type t_left  = left->generate();
-  symbol_type t_right = right->generate();
+  symbol_type t_result = arithmetic_type(t_left, t_right);
+  if (t_result == tERROR) return tERROR;
 
-  if (t_left != tINT || t_left != tINT) {
-    cerr << "ERROR: Multiplication only supported with INTs on line"
-	 << line_number << endl;
-    return tERROR;
-  }
+  result = ir->compute(IR_MUL, t_result, l, r);
+  return t_result;
+}
 
-  //  Yuck.
-
-  // Use the registers to do repetitive addition.
-  output << "    pop r0" << endl
-	 << "    pop r1" << endl
-	 << "    copy 0, r2" << endl
-	 << label1 << ":" << endl
-	 << "    cmp r0, 0" << endl
-	 << "    jz " << label2 << endl
-         << "    clc" << endl 
-	 << "    add r1, r2" << endl
-	 << "    dec r0" << endl
-	 << "    jmp " << label1 << endl
-	 << label2 << ":" << endl
-         // Leave the result on the stack.
-	 << "    push r2" << endl;
-  return tINT;
+void div_node::annotate()
+{
+  result_type = arithmetic_type(left->expression_type(), right->expression_type());
+  order_operands(left->registers_needed(), left->registers_held(),
+                 right->registers_needed(), right->registers_held());
+
+  // The dividend (which becomes the quotient) and the remainder are the width of the result
+  // and there is a counter. The divisor is only read so it is used where it is.
+  //
+  int w = width(result_type);
+  need = max(need, 2 * w + 1 + right->registers_held());
 }
 
-symbol_type div_node::generate()
+// Division by zero is left for run time.
+expr_node *div_node::fold()
 {
-  string label1 = next_label();
-  string label2 = next_label();
+  if (result_type == tERROR) return this;
 
-  // Generate the left and right expressions first.
-  symbol_type t_left  = left->generate();
-  symbol_type t_right = right->generate();
+  unsigned long l, r;
+  if (!right->is_constant(r) || r == 0) return this;
 
-  if (t_left != tINT || t_left != tINT) {
-    cerr << "ERROR: Multiplication only supported with INTs on line"
-	 << line_number << endl;
-    return tERROR;
-  }
+  if (left->is_constant(l)) return constant(l / r, result_type, line_number);
+  if (left->expression_type() != result_type) return this;
+  if (r == 1) return left;
+  int n = power_of_two(r);
+  if (n > 0 && result_type == tINT) return shift(left, SHIFT_RIGHT, n, line_number);
+  return this;
+}
+
+symbol_type div_node::generate(ir_operand &result)
+{
+  ir_operand l, r;
+  symbol_type t_left, t_right;
+  generate_operands(t_left, l, t_right, r);
+
+  symbol_type t_result = arithmetic_type(t_left, t_right);
+  if (t_result == tERROR) return tERROR;
+
+  result = ir->compute(IR_DIV, t_result, l, r);
+  return t_result;
+}
+
+void shift_node::bind()
+{
+  operand_expression->bind();
+}
 
-  //  Yuck.
-
-  // Use the registers to do repetitive subtraction.
-  output << "    pop r0" << endl        // Divisor
-	 << "    pop r1" << endl 
-	 << "    copy 0, r2" << endl     // Result
-	 << label1 << ":" << endl
-         << "    clc" << endl 
-	 << "    sub r0, r1" << endl
-	 << "    jc " << label2 << endl // Stop on a borrow.
-	 << "    inc r2" << endl        // Count this subtraction.
-	 << "    jmp " << label1 << endl
-	 << label2 << ":" << endl
-         // Leave the result on the stack.
-	 << "    push r2" << endl;
+void shift_node::annotate()
+{
+  result_type = (operand_expression->expression_type() == tINT) ? tINT : tERROR;
+  need = max(operand_expression->registers_needed(), 1);
+}
+
+expr_node *shift_node::simplify()
+{
+  operand_expression = operand_expression->simplify();
+  annotate();
+  return this;
+}
+
+symbol_type shift_node::generate(ir_operand &result)
+{
+  ir_operand value;
+  symbol_type t_value = operand_expression->generate(value);
+  if (t_value != tINT) return tERROR;
+
+  result = ir->shift(direction == SHIFT_LEFT ? IR_SHL : IR_SHR, value, count);
   return tINT;
 }
 
-symbol_type num_node::generate()
+void num_node::bind()
+{ }
+
+// Constants are used directly as operands.
+void num_node::annotate()
 {
-  if (num_type == tINT) {
-    output << "    push " << value << endl;
-  }
-  else if (num_type == tLONG) {
-    // Put MSW first.
-    output << "    push " << (value >> 16) << endl
-	   << "    push " << (value & 0xFFFF) << endl;
-  }
-  else {
-    cerr << " Can't generate number on line " << line_number << endl;
+  result_type = num_type;
+  need = 0;
+}
+
+expr_node *num_node::simplify()
+{
+  annotate();
+  return this;
+}
+
+bool num_node::is_constant(unsigned long &result) const
+{
+  if (num_type != tINT && num_type != tLONG) return false;
+  result = static_cast<unsigned int>(value) & value_mask(num_type);
+  return true;
+}
+
+symbol_type num_node::generate(ir_operand &result)
+{
+  if (num_type != tINT && num_type != tLONG) {
+    error_message() << " Can't generate number on line " << line_number << endl;
     return tERROR;
   }
+  result = ir_operand::constant(value, num_type);
   return num_type;
 }
 
 
-// This function places the contents of the variable on the stack and returns the type of the
-// variable so the next node up knows how many words to remove from the stack.
+void id_node::bind()
+{
+  symbol = symbols->lookup(symbol_id);
+}
+
+expr_node *id_node::simplify()
+{
+  annotate();
+  return this;
+}
+
+// Int variables are used directly as operands. Longs are loaded into a pair of registers.
+void id_node::annotate()
+{
+  result_type = tERROR;
+  need = 1;
+  if (symbol != 0) {
+    if (symbol->vartype == tINT) {
+      result_type = tINT;
+      need = 0;
+    }
+    else if (symbol->vartype == tLONG) {
+      result_type = tLONG;
+      need = 2;
+    }
+  }
+}
+
+// This function describes where the value of the variable is and returns its type so the node
+// above knows how many words it has.
 //
-symbol_type id_node::generate()
+symbol_type id_node::generate(ir_operand &result)
 {
-  // Look up the type of the symbol.
-  std::map<std::string, symbol_attrs>::const_iterator symbol;
-  symbol = symbol_table.find(name);
-  if (symbol == symbol_table.end()) {
-    cerr << "ERROR - symbol " << name << "on line " 
+  // The symbol was looked up by bind().
+  const char *name = symbols->name(symbol_id);
+  if (symbol == 0) {
+    error_message() << "ERROR - symbol " << name << "on line "
 	 << line_number << " not found!" << endl;
-    exit(1);
+    return tERROR;
   }
-  // If it's an int, just put it on the stack.
-  if (symbol->second.vartype == tINT) {
-    output << "    push (_" << name << ")" << endl;
+  // If it's an int, the variable itself can be used.
+  if (symbol->vartype == tINT) {
+    result = ir_operand::variable(name);
     return tINT;
   }
-  // If it's a long, more work needs to be done. I want to keep longs in memory on the stack in
-  // the same byte ordering as normal memory, so I will need to push the higher address first
-  // (because the stack grows toward lower addresses). Because the assembler is too dumb to be
-  // able to do math for constants (eg. _varname + 1), I will have to use a register to do this.
-  // This is inefficient at best, and the assembler should have constant math handling added.
-  //
-  if (symbol->second.vartype == tLONG) {
-    
-    output << "    copy _" << name << ", r0" << endl
-	   << "    inc r0" << endl
-	   << "    push (r0)" << endl
-	   << "    dec r0" << endl
-	   << "    push (r0)" << endl;
+  // If it's a long, it has to be loaded.
+  if (symbol->vartype == tLONG) {
+    result = ir->load(name, tLONG);
     return tLONG;
   }
 
+  error_message() << "ERROR - array " << name << " used without an index on line "
+       << line_number << endl;
+  return tERROR;
 }
 
-symbol_type arrayref_node::generate()
+void arrayref_node::annotate()
 {
-  // Look up the type of the symbol.
-  std::map<std::string, symbol_attrs>::const_iterator symbol;
-  symbol = symbol_table.find(array_name);
-  if (symbol == symbol_table.end()) {
-    cerr << "ERROR - symbol " << array_name << " on line" 
-	 << line_number << " not found!" << endl;
-    return tERROR;
+  result_type = tERROR;
+  if (symbol != 0) {
+    if (symbol->vartype == tINTARRAY) result_type = tINT;
+    if (symbol->vartype == tLONGARRAY) result_type = tLONG;
   }
+  need = max(index_expression->registers_needed(), width(result_type));
+}
 
-  // Generating the index expression should leave the index on the top of the stack.
-  symbol_type t_index = index_expression->generate();
-  if (t_index == tERROR) {
+void arrayref_node::bind()
+{
+  symbol = symbols->lookup(array_id);
+  index_expression->bind();
+}
+
+expr_node *arrayref_node::simplify()
+{
+  index_expression = index_expression->simplify();
+  annotate();
+  return this;
+}
+
+symbol_type arrayref_node::generate(ir_operand &result)
+{
+  // The symbol was looked up by bind().
+  const char *array_name = symbols->name(array_id);
+  if (symbol == 0) {
+    error_message() << "ERROR - symbol " << array_name << " on line"
+	 << line_number << " not found!" << endl;
     return tERROR;
   }
 
+  ir_operand index;
+  symbol_type t_index = index_expression->generate(index);
+  if (t_index == tERROR) return tERROR;
+
   // The index should only be an int. If it is a long, generate a warning and just use the LSW.
   if (t_index == tLONG) {
-    cerr << "WARNING: LONG expression used as index into array " 
+    *diagnostics << "WARNING: LONG expression used as index into array "
 	 << array_name << " on line " << line_number << endl
 	 << "Only lower word will be used." << endl;
-    // Remove entire long (lower word first) and place just the lower word back on the stack.
-    // This ensures the index on the stack is always one word long.
-    output << "    pop r0" << endl
-	   << "    pop r1" << endl
-	   << "    push r0" << endl;
-  }
-
-  if (symbol->second.vartype == tINTARRAY) {
-    // Use a register to manually locate the desired element. No bounds checking is done.
-    output << "    pop r0" << endl
-	   << "    copy _" << array_name << ", r1" << endl
-	   << "    clc" << endl
-	   << "    add r0, r1" << endl
-	   << "    push (r1)" << endl;
+  }
+
+  if (symbol->vartype == tINTARRAY) {
+    result = ir->load_element(array_name, tINT, index);
     return tINT;
   }
-  else if (symbol->second.vartype == tLONGARRAY) {
-    // Use a register to manually locate the desired element. For a long, we need to multiply
-    // the index by two (using a left shift). No bounds checking is done.
-    output << "    pop r0" << endl
-	   << "    clc" << endl    // Not sure if shift uses carry or not.
-	   << "    shl r0" << endl
-	   << "    copy _" << array_name << ", r1" << endl
-	   << "    clc" << endl
-	   << "    add r0, r1" << endl
-	   << "    inc r1" << endl // Push the MSW first.
-	   << "    push (r1)" << endl
-	   << "    dec r1" << endl
-	   << "    push (r1)" << endl;
+  else if (symbol->vartype == tLONGARRAY) {
+    result = ir->load_element(array_name, tLONG, index);
     return tLONG;
   }
 
@@ -686,204 +644,217 @@ symbol_type arrayref_node::generate()
   return tERROR;
 }
 
-void statementlist_node::generate()
+block_node::block_node(const std::vector<stmt_node *> &list)
+  : statements(0), count(static_cast<int>(list.size()))
+{
+  count_node(BLOCK_NODE);
+  statements = static_cast<stmt_node **>(node_arena->allocate(count * sizeof(stmt_node *)));
+  for (int i = 0; i < count; ++i) {
+    statements[i] = list[i];
+  }
+}
+
+void block_node::bind()
+{
+  for (int i = 0; i < count; ++i) {
+    statements[i]->bind();
+  }
+}
+
+void block_node::generate()
 {
-  // Generate any previous statements.
-  if (statement_list != NULL) {
-    statement_list->generate();
+  for (int i = 0; i < count; ++i) {
+    statements[i]->generate();
   }
-  // Generate this statement.
-  statement->generate();
   return;
 }
 
+
+// Evaluates the expression as a value and tests it. Expressions with nothing better to do use
+// this. A constant needs no test at all.
+//
+void expr_node::generate_branch(int if_true, int if_false)
+{
+  unsigned long value;
+  if (is_constant(value)) {
+    ir->jump(value != 0 ? if_true : if_false);
+    return;
+  }
+
+  ir_operand condition;
+  symbol_type t_condition = generate(condition);
+  if (t_condition == tERROR) return;
+  ir->test(condition, if_true, if_false);
+}
+
+void if_node::bind()
+{
+  expression->bind();
+  then_clause->bind();
+  if (else_clause) else_clause->bind();
+}
+
 void if_node::generate()
 {
-  string label1 = next_label();
-  string label2 = next_label();
-  // Generate the expression, leaving the result on the top of the stack.
-  expression->generate();
-  // See what happened.
-  output << "    pop r0" << endl
-	 << "    cmp r0, 0" << endl
-	 << "    jz " << label1 << endl;
+  int then_block = ir->new_block();
+  int else_block = else_clause ? ir->new_block() : -1;
+  int done       = ir->new_block();
+  expression = expression->simplify();
+  expression->generate_branch(then_block, else_clause ? else_block : done);
+  ir->start(then_block);
   then_clause->generate();
-  output << "    jmp " << label2 << endl
-	 << label1 << ":" << endl;
-  if(else_clause) else_clause->generate();
-  output << label2 << ":" << endl;
-  
+  if (else_clause) {
+    ir->jump(done);
+    ir->start(else_block);
+    else_clause->generate();
+  }
+  ir->start(done);
   return;
 }
 
-void while_node::generate()
+void while_node::bind()
 {
-  string label1 = next_label();
-  string label2 = next_label();
+  expression->bind();
+  statement_list->bind();
+}
 
-  // Check the expression each time at the top.
-  output << label1 << ":" << endl;
-  expression->generate();
-  output << "    pop r0" << endl
-	 << "    cmp r0, 0" << endl
-	 << "    jz " << label2 << endl;
+void while_node::generate()
+{
+  int body      = ir->new_block();
+  int condition = ir->new_block();
+  int done      = ir->new_block();
+
+  // The expression is checked at the bottom so that each iteration only takes one jump.
+  expression = expression->simplify();
+  ir->jump(condition);
+  ir->start(body);
   statement_list->generate();
-  output << "    jmp " << label1 << endl
-	 << label2 << ":" << endl;
+  ir->start(condition);
+  expression->generate_branch(body, done);
+  ir->start(done);
   return;
 }
 
+void return_node::bind()
+{
+  expression->bind();
+}
+
 void return_node::generate()
 {
-  // Have the expression evaluate itself and just leave the result on the top of the stack.
-  expression->generate();
-  output << "    halt" << endl;
+  // The result is left on the top of the stack.
+  ir_operand result;
+  expression = expression->simplify();
+  symbol_type t_result = expression->generate(result);
+  if (t_result == tERROR) result = ir_operand::none();
+  ir->return_value(result);
   return;
 }
 
+void assignment_node::bind()
+{
+  symbol = symbols->lookup(symbol_id);
+  expression->bind();
+}
+
 void assignment_node::generate()
 {
-  // Look up the type of the symbol.
-  std::map<std::string, symbol_attrs>::const_iterator symbol;
-  symbol = symbol_table.find(name);
-  if (symbol == symbol_table.end()) {
-    cerr << "ERROR - symbol " << name << " on line " 
+  // The symbol was looked up by bind().
+  const char *name = symbols->name(symbol_id);
+  if (symbol == 0) {
+    error_message() << "ERROR - symbol " << name << " on line "
 	 << line_number << " not found!" << endl;
     return;
   }
 
   // Get the type of the generated expression.
-  symbol_type t_expr = expression->generate();
+  ir_operand value;
+  expression = expression->simplify();
+  symbol_type t_expr = expression->generate(value);
   if (t_expr == tERROR) {
-    cerr << "ERROR - error generating rvalue for assignment to " 
+    error_message() << "ERROR - error generating rvalue for assignment to "
 	 << name << " on line " << line_number << endl;
     return;
   }
 
   // Run through all of the possible lvalue/rvalue type combos.
-  if (symbol->second.vartype == tINT) {
-    if (t_expr == tINT) {
-      output << "    pop (_" << name << ")" << endl;
-    }
-    else if (t_expr == tLONG) {
-      cerr << "WARNING: LONG expression assigned to INT " 
+  if (symbol->vartype == tINT) {
+    if (t_expr == tLONG) {
+      *diagnostics << "WARNING: LONG expression assigned to INT "
 	   << name << " on line " << line_number << endl
 	   << "Only lower word will be used." << endl;
-      // Lower word comes off stack first.
-      output << "    pop (_" << name << ")" << endl
-	     << "    pop r0" << endl; // Throw away the rest.
     }
+    ir->store(name, tINT, value);
+  }
+  else if (symbol->vartype == tLONG) {
+    // An INT gets a 0 for its MSW.
+    ir->store(name, tLONG, value);
   }
-  else if (symbol->second.vartype == tLONG) {
-    // Just move a 0 into the MSW.
-    if (t_expr == tINT) {
-      output << "    copy _" << name << ", r0" << endl
-	     << "    pop (r0)" << endl
-	     << "    inc r0" << endl
-	     << "    copy 0, (r0)" << endl;
-    }
-    else if (t_expr == tLONG) {
-      // Lower word comes off stack first.
-      output << "    copy _" << name << ", r0" << endl
-	     << "    pop (r0)" << endl
-	     << "    inc r0" << endl
-	     << "    pop (r0)" << endl;
-    }
-  }    
   return;
 }
 
+void arrayassign_node::bind()
+{
+  symbol = symbols->lookup(array_id);
+  index_expression->bind();
+  expression->bind();
+}
+
 void arrayassign_node::generate()
 {
-  // Look up the type of the symbol.
-  std::map<std::string, symbol_attrs>::const_iterator symbol;
-  symbol = symbol_table.find(array_name);
-  if (symbol == symbol_table.end()) {
-    cerr << "ERROR - symbol " << array_name << " on line "
+  // The symbol was looked up by bind().
+  const char *array_name = symbols->name(array_id);
+  if (symbol == 0) {
+    error_message() << "ERROR - symbol " << array_name << " on line "
 	 << line_number << " not found!" << endl;
     return;
   }
 
-  // Get the type of the generated expression.
-  symbol_type t_expr = expression->generate();
+  // Evaluate whichever expression needs more registers first.
+  ir_operand value, index;
+  symbol_type t_expr, t_index;
+  expression = expression->simplify();
+  index_expression = index_expression->simplify();
+  if (index_expression->registers_needed() > expression->registers_needed()) {
+    t_index = index_expression->generate(index);
+    t_expr  = expression->generate(value);
+  }
+  else {
+    t_expr  = expression->generate(value);
+    t_index = index_expression->generate(index);
+  }
+
   if (t_expr == tERROR) {
-    cerr << "ERROR - error generating rvalue for assignment to " 
+    error_message() << "ERROR - error generating rvalue for assignment to "
 	 << array_name << " on line " << line_number << endl;
     return;
   }
-
-  // Leave the rvalue on the stack and generate the index.
-  symbol_type t_index = index_expression->generate();
   if (t_index == tERROR) {
-    cerr << "ERROR - unable to generate index expression for array " 
+    error_message() << "ERROR - unable to generate index expression for array "
 	 << array_name << " on line " << line_number << endl;
     return;
   }
 
-  // The index should only be an int.  If it is a long, generate 
+  // The index should only be an int.  If it is a long, generate
   // a warning and just use the LSW.
   if (t_index == tLONG) {
-    cerr << "WARNING: LONG expression used as index into array " 
+    *diagnostics << "WARNING: LONG expression used as index into array "
 	 << array_name << " on line " << line_number << endl
 	 << "Only lower word will be used." << endl;
-    // Remove entire long (lower word first) and place just the lower word back on the stack.
-    // This ensures the index on the stack is always one word long.
-    output << "    pop r0" << endl
-	   << "    pop r1" << endl
-	   << "    push r0" << endl;
   }
 
   // Run through all of the possible lvalue/rvalue type combos.
-  if (symbol->second.vartype == tINTARRAY) {
-    if (t_expr == tINT) {
-      // Compute the effective address.
-      output << "    pop r0" << endl
-	     << "    copy _" << array_name << ", r1" << endl
-	     << "    add r0, r1" << endl
-	     // Store the rvalue there.
-	     << "    pop (r1)" << endl;
-    }
-    else if (t_expr == tLONG) {
-      cerr << "WARNING: LONG expression assigned to INTARRAY " 
+  if (symbol->vartype == tINTARRAY) {
+    if (t_expr == tLONG) {
+      *diagnostics << "WARNING: LONG expression assigned to INTARRAY "
 	   << array_name << " on line " << line_number << endl
 	   << "Only lower word will be used." << endl;
-      // Compute the effective address.
-      output << "    pop r0" << endl
-	     << "    copy _" << array_name << ", r1" << endl
-	     << "    add r0, r1" << endl
-	     // Store the rvalue there.
-	     << "    pop (r1)" << endl
-	     << "    pop r0" << endl; // Throw away the rest.
     }
+    ir->store_element(array_name, tINT, index, value);
+  }
+  else if (symbol->vartype == tLONGARRAY) {
+    // An INT gets a 0 for its MSW.
+    ir->store_element(array_name, tLONG, index, value);
   }
-  else if (symbol->second.vartype == tLONGARRAY) {
-    // Just move a 0 into the MSW.
-    if (t_expr == tINT) {
-      output << "    pop r0" << endl
-	     << "    clc" << endl    // Not sure if shift uses carry or not.
-	     << "    shl r0" << endl
-	     << "    copy _" << array_name << ", r1" << endl
-	     << "    clc" << endl
-	     << "    add r0, r1" << endl
-	     << "    pop (r1) " << endl // Pop of LSW first.
-	     << "    inc r1" << endl
-	     << "    copy 0, (r1)" << endl;
-    }
-    else if (t_expr == tLONG) {
-      // Lower word comes off stack first. Use a register to manually locate the desired
-      // element. For a long, we need to multiply the index by two (using a left shift). No
-      // bounds checking is done.
-      output << "    pop r0" << endl
-	     << "    clc" << endl    // Not sure if shift uses carry or not.
-	     << "    shl r0" << endl
-	     << "    copy _" << array_name << ", r1" << endl
-	     << "    clc" << endl
-	     << "    add r0, r1" << endl
-	     << "    pop (r1) " << endl // Pop of LSW first.
-	     << "    inc r1" << endl
-	     << "    pop (r1)" << endl;
-    }
-  }    
   return;
-
 }
@@ -14,125 +14,219 @@ Please send comments or bug reports to
 #ifndef NODETYPES_H
 #define NODETYPES_H
 
-#include <string>
-#include <map>
-
-enum symbol_type { tINT, tLONG, tINTARRAY, tLONGARRAY , tERROR};
-
-// Make a structure to store all of the attributes of the variables.
-struct symbol_attrs {
-  symbol_type vartype;
-  int num_elements; 
-};
-
-// Declaring the symbol table.
-extern std::map<std::string, symbol_attrs> symbol_table;
+#include <iosfwd>
+#include <vector>
+#include "arena.h"
+#include "code-buffer.h"
+#include "intermediate-code.h"
+#include "statistics.h"
+#include "symbol-table.h"
 
 //
 // Expression syntax nodes
 //
 
-// typedef int tlocation_t;
+// Where errors and warnings about the function being compiled are written. Each thread has its
+// own so that messages can be reported in source order whatever order functions are compiled in.
+//
+extern thread_local std::ostream *diagnostics;
+
+// Counts the errors written to diagnostics (but not the warnings) for the function being
+// compiled. A function with errors has no usable code. Null when no function is being compiled.
+//
+extern thread_local int *error_count;
 
+// Nodes are allocated in node_arena and are never individually deleted. The whole tree is
+// released at once when compilation ends. Thus nodes have no destructors. Names are kept as
+// symbol IDs (see symbol-table.h) rather than as std::string objects.
+//
 class expr_node {
+protected:
+  symbol_type result_type;  // Set by annotate().
+  int need;                 // Registers needed to evaluate this expression. Set by annotate().
+
 public:
-  virtual ~expr_node() { }
-  virtual symbol_type generate() = 0;
+  static void *operator new(std::size_t size) { return node_arena->allocate(size); }
+  static void  operator delete(void *) { }
+
+  // Resolves the symbols used by the expression. This is done once, after parsing.
+  virtual void bind() = 0;
+
+  // Works out the type of the expression and how many registers it needs (its Sethi-Ullman
+  // number). The operands must already be annotated. Errors are not reported here; generate()
+  // does that.
+  //
+  virtual void annotate() = 0;
+
+  // Folds constant subexpressions and simplifies identities such as x + 0. Returns the node to
+  // use in place of this one, which might be this node. The returned tree is annotated.
+  //
+  virtual expr_node *simplify() = 0;
+
+  // Returns true and the value if the expression is a constant.
+  virtual bool is_constant(unsigned long &) const { return false; }
+
+  // Appends intermediate code (see intermediate-code.h) that evaluates the expression to the
+  // current function and describes the result. The expression must have been annotated.
+  //
+  virtual symbol_type generate(ir_operand &result) = 0;
+
+  // Appends intermediate code that goes to the block if_true if the expression is true (nonzero)
+  // and to the block if_false otherwise. Conditions of if and while statements are generated
+  // this way. The expression must have been annotated.
+  //
+  virtual void generate_branch(int if_true, int if_false);
+
+  symbol_type expression_type() const { return result_type; }
+  int registers_needed() const { return need; }
+
+  // Returns the number of registers holding the result while the rest of an expression is
+  // evaluated. Results that are used directly as operands don't hold any.
+  //
+  int registers_held() const
+    { return need == 0 ? 0 : (result_type == tLONG ? 2 : 1); }
 };
 
 
-class and_node : public expr_node {
-private:
+// Base of the nodes with two operands. The operand needing more registers is evaluated first
+// so that fewer values are held in registers (or spilled) at once.
+//
+class binary_node : public expr_node {
+protected:
   expr_node *left, *right;
   int line_number;
+  bool right_first;
+
+  binary_node(expr_node *l, expr_node *r, int line)
+    : left(l), right(r), line_number(line), right_first(false) { }
+
+  // Chooses the order of evaluation and sets need. The arguments are the registers each
+  // operand needs and the registers it holds while the other operand is evaluated.
+  //
+  void order_operands(int left_need, int left_held, int right_need, int right_held);
+
+  // Returns a simpler node that computes the same value as this one, or this node if there
+  // isn't one. The operands have already been simplified and this node has been annotated.
+  //
+  virtual expr_node *fold() { return this; }
+
+  void generate_operands(symbol_type &t_left, ir_operand &l, symbol_type &t_right, ir_operand &r);
+
 public:
-  and_node(expr_node *l, expr_node *r, int line) 
-    : left(l), right(r), line_number(line) { }
-  virtual ~and_node() { delete left; delete right; }
-  virtual symbol_type generate();
+  virtual void bind();
+  virtual expr_node *simplify();
 };
 
 
-class or_node : public expr_node {
-private:
-  expr_node *left, *right;
-  int line_number;
-
+class and_node : public binary_node {
 public:
-  or_node(expr_node *l, expr_node *r, int line) 
-    : left(l), right(r), line_number(line) { }
-  virtual ~or_node() { delete left; delete right; }
-  virtual symbol_type generate();
+  and_node(expr_node *l, expr_node *r, int line)
+    : binary_node(l, r, line) { count_node(AND_NODE); }
+  virtual void annotate();
+  virtual symbol_type generate(ir_operand &result);
+  virtual void generate_branch(int if_true, int if_false);
+
+protected:
+  virtual expr_node *fold();
 };
 
 
-enum relational_type
-  { EQ_TYPE, NE_TYPE, LT_TYPE, GT_TYPE, LE_TYPE, GE_TYPE };
+class or_node : public binary_node {
+public:
+  or_node(expr_node *l, expr_node *r, int line)
+    : binary_node(l, r, line) { count_node(OR_NODE); }
+  virtual void annotate();
+  virtual symbol_type generate(ir_operand &result);
+  virtual void generate_branch(int if_true, int if_false);
+
+protected:
+  virtual expr_node *fold();
+};
 
 
-class relational_node : public expr_node {
+class relational_node : public binary_node {
 private:
-  expr_node *left, *right;
   relational_type type;
-  int line_number;
 
 public:
-  relational_node(expr_node *l, expr_node *r, relational_type t, int line) 
-    : left(l), right(r), type(t), line_number(line) { }
-  virtual ~relational_node() { delete left; delete right; }
-  virtual symbol_type generate();
+  relational_node(expr_node *l, expr_node *r, relational_type t, int line)
+    : binary_node(l, r, line), type(t) { count_node(RELATIONAL_NODE); }
+  virtual void annotate();
+  virtual symbol_type generate(ir_operand &result);
+  virtual void generate_branch(int if_true, int if_false);
+
+protected:
+  virtual expr_node *fold();
 };
 
 
-class add_node : public expr_node {
-private:
-  expr_node *left, *right;
-  int line_number;
-
+class add_node : public binary_node {
 public:
-  add_node(expr_node *l, expr_node *r, int line) 
-    : left(l), right(r), line_number(line) { }
-  virtual ~add_node() { delete left; delete right; }
-  virtual symbol_type generate();
-};
+  add_node(expr_node *l, expr_node *r, int line)
+    : binary_node(l, r, line) { count_node(ADD_NODE); }
+  virtual void annotate();
+  virtual symbol_type generate(ir_operand &result);
 
+protected:
+  virtual expr_node *fold();
+};
 
-class sub_node : public expr_node {
-private:
-  expr_node *left, *right;
-  int line_number;
 
+class sub_node : public binary_node {
 public:
-  sub_node(expr_node *l, expr_node *r, int line) 
-    : left(l), right(r), line_number(line) { }
-  virtual ~sub_node() { delete left; delete right; }
-  virtual symbol_type generate();
+  sub_node(expr_node *l, expr_node *r, int line)
+    : binary_node(l, r, line) { count_node(SUB_NODE); }
+  virtual void annotate();
+  virtual symbol_type generate(ir_operand &result);
+
+protected:
+  virtual expr_node *fold();
 };
 
 
-class mul_node : public expr_node {
-private:
-  expr_node *left, *right;
-  int line_number;
+class mul_node : public binary_node {
+public:
+  mul_node(expr_node *l, expr_node *r, int line)
+    : binary_node(l, r, line) { count_node(MUL_NODE); }
+  virtual void annotate();
+  virtual symbol_type generate(ir_operand &result);
+
+protected:
+  virtual expr_node *fold();
+};
 
+
+class div_node : public binary_node {
 public:
-  mul_node(expr_node *l, expr_node *r, int line) 
-    : left(l), right(r), line_number(line) { }
-  virtual ~mul_node() { delete left; delete right; }
-  virtual symbol_type generate();
+  div_node(expr_node *l, expr_node *r, int line)
+    : binary_node(l, r, line) { count_node(DIV_NODE); }
+  virtual void annotate();
+  virtual symbol_type generate(ir_operand &result);
+
+protected:
+  virtual expr_node *fold();
 };
 
 
-class div_node : public expr_node {
+enum shift_type { SHIFT_LEFT, SHIFT_RIGHT };
+
+// Multiplication and division of an int by a power of two are done with shifts. These nodes
+// are only created by simplify().
+//
+class shift_node : public expr_node {
 private:
-  expr_node *left, *right;
+  expr_node *operand_expression;
+  shift_type direction;
+  int count;
   int line_number;
 
 public:
-  div_node(expr_node *l, expr_node *r, int line) 
-    : left(l), right(r), line_number(line) { }
-  virtual ~div_node() { delete left; delete right; }
-  virtual symbol_type generate();
+  shift_node(expr_node *e, shift_type d, int n, int line)
+    : operand_expression(e), direction(d), count(n), line_number(line) { count_node(SHIFT_NODE); }
+  virtual void bind();
+  virtual void annotate();
+  virtual expr_node *simplify();
+  virtual symbol_type generate(ir_operand &result);
 };
 
 
@@ -144,34 +238,46 @@ private:
 
 public:
   num_node(int v, symbol_type t, int line) 
-    : value(v), num_type(t), line_number(line) { }
-  virtual symbol_type generate();
+    : value(v), num_type(t), line_number(line) { count_node(NUM_NODE); }
+  virtual void bind();
+  virtual void annotate();
+  virtual expr_node *simplify();
+  virtual bool is_constant(unsigned long &result) const;
+  virtual symbol_type generate(ir_operand &result);
 };
 
 
 class id_node : public expr_node {
 private:
-  std::string name;
+  int symbol_id;
+  const symbol_attrs *symbol;  // Set by bind(). Null if the name isn't declared.
   int line_number;
   
 public:
-  id_node(const std::string &n, int line) 
-    : name(n), line_number(line) { }
-  virtual symbol_type generate();
+  id_node(int id, int line) 
+    : symbol_id(id), symbol(0), line_number(line) { count_node(ID_NODE); }
+  virtual void bind();
+  virtual void annotate();
+  virtual expr_node *simplify();
+  virtual symbol_type generate(ir_operand &result);
 };
 
 
 class arrayref_node : public expr_node {
 private:
-  std::string array_name;
+  int array_id;
+  const symbol_attrs *symbol;  // Set by bind(). Null if the name isn't declared.
   expr_node *index_expression;
   int line_number;
 
 public:
-  arrayref_node(std::string &n, expr_node *index, int line) :
-    array_name(n), index_expression(index), line_number(line) { }
-  virtual ~arrayref_node() { delete index_expression; }
-  virtual symbol_type generate();
+  arrayref_node(int id, expr_node *index, int line) :
+    array_id(id), symbol(0), index_expression(index), line_number(line)
+    { count_node(ARRAYREF_NODE); }
+  virtual void bind();
+  virtual void annotate();
+  virtual expr_node *simplify();
+  virtual symbol_type generate(ir_operand &result);
 };
 
 
@@ -182,19 +288,27 @@ public:
 
 class stmt_node {
 public:
-  virtual ~stmt_node() { }
+  static void *operator new(std::size_t size) { return node_arena->allocate(size); }
+  static void  operator delete(void *) { }
+
+  // Resolves the symbols used by the statement. This is done once, after parsing.
+  virtual void bind() = 0;
+
+  // Appends the intermediate code of the statement to the current function.
   virtual void generate() = 0;
 };
 
-class statementlist_node : public stmt_node {
+// A sequence of statements. The statements are kept in a contiguous array (in the arena) so
+// that long sequences are generated with a loop rather than by recursion.
+//
+class block_node : public stmt_node {
 private:
-  stmt_node *statement_list;
-  stmt_node *statement;
+  stmt_node **statements;
+  int count;
 
 public:
-  statementlist_node(stmt_node *s_list, stmt_node *s) :
-    statement_list(s_list), statement(s) { }
-  virtual ~statementlist_node() { delete statement_list; delete statement; }
+  explicit block_node(const std::vector<stmt_node *> &list);
+  virtual void bind();
   virtual void generate();
 };
 
@@ -208,10 +322,9 @@ private:
 public:
   if_node(expr_node *e, stmt_node *t_clause, stmt_node *e_clause) :
     expression(e), then_clause(t_clause), else_clause(e_clause)
-  { }
+  { count_node(IF_NODE); }
 
-  virtual ~if_node()
-    { delete expression; delete then_clause, delete else_clause; }
+  virtual void bind();
   virtual void generate();
 };
 
@@ -224,10 +337,9 @@ private:
 public:
   while_node(expr_node *e, stmt_node *s_list) :
     expression(e), statement_list(s_list)
-  { }
+  { count_node(WHILE_NODE); }
 
-  virtual ~while_node()
-    { delete expression; delete statement_list; }
+  virtual void bind();
   virtual void generate();
 };
 
@@ -237,43 +349,43 @@ private:
   expr_node *expression;
 
 public:
-  return_node(expr_node *e) : expression(e) { }
+  return_node(expr_node *e) : expression(e) { count_node(RETURN_NODE); }
 
-  virtual ~return_node()
-    { delete expression; }
+  virtual void bind();
   virtual void generate();
 };
 
 
 class assignment_node : public stmt_node {
 private:
-  std::string name;
+  int symbol_id;
+  const symbol_attrs *symbol;  // Set by bind(). Null if the name isn't declared.
   expr_node *expression;
   int line_number;
   
 public:
-  assignment_node(const std::string &n, expr_node *e, int line) :
-    name(n), expression(e), line_number(line) { }
+  assignment_node(int id, expr_node *e, int line) :
+    symbol_id(id), symbol(0), expression(e), line_number(line) { count_node(ASSIGNMENT_NODE); }
 
-  virtual ~assignment_node()
-    { delete expression; }
+  virtual void bind();
   virtual void generate();
 };
 
 
 class arrayassign_node : public stmt_node {
 private:
-  std::string array_name;
+  int array_id;
+  const symbol_attrs *symbol;  // Set by bind(). Null if the name isn't declared.
   expr_node *index_expression;
   expr_node *expression;
   int line_number;
 
 public:
-  arrayassign_node(const std::string &n, expr_node *index, expr_node *e, int line) :
-    array_name(n), index_expression(index), expression(e), line_number(line) { }
+  arrayassign_node(int id, expr_node *index, expr_node *e, int line) :
+    array_id(id), symbol(0), index_expression(index), expression(e), line_number(line)
+    { count_node(ARRAYASSIGN_NODE); }
 
-  virtual ~arrayassign_node()
-    { delete index_expression; delete expression; }
+  virtual void bind();
   virtual void generate();
 };
 
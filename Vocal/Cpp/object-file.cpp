@@ -0,0 +1,203 @@
+/****************************************************************************
+FILE      : object-file.cpp
+SUBJECT   : Implementation of the OJ object file writer.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "object-file.h"
+#include "instruction-list.h"
+#include <unordered_map>
+#include <vector>
+
+// Where the storage and labels of a function are in the object data. Offsets are in words.
+struct function_layout {
+  typedef std::unordered_map<const char *, unsigned> variable_map;
+
+  // Names are interned, so every use of a variable has the same name pointer.
+  variable_map variables;
+  std::vector<unsigned> labels;  // Indexed by label number.
+  unsigned start;                // Offset of the function's first instruction.
+
+  function_layout() : start(0) { }
+};
+
+// Formats object data. Words are collected into a line and the line is written with the
+// relocations of the addresses in it.
+//
+class object_writer {
+public:
+  explicit object_writer(code_buffer &o) : out(o), offset(0), count(0) { }
+
+  // Adds a word that doesn't need relocation.
+  void word(unsigned value);
+
+  // Adds a word holding an offset into the object data, which the linker must relocate.
+  void address(unsigned value);
+
+  // Writes out the words collected so far.
+  void end_line();
+
+private:
+  // Lines are kept well under the 128 characters OJ readers are allowed to insist on.
+  static const int line_words = 8;
+
+  code_buffer &out;
+  unsigned     offset;                   // Offset of the next word.
+  unsigned     words[line_words];
+  int          count;
+  std::vector<unsigned> relocations;     // Offsets of the addresses in the current line.
+};
+
+
+void object_writer::word(unsigned value)
+{
+  if (count == line_words) end_line();
+  words[count++] = value & 0xFFFF;
+  ++offset;
+}
+
+
+void object_writer::address(unsigned value)
+{
+  if (count == line_words) end_line();
+  relocations.push_back(offset);
+  word(value);
+}
+
+
+// Each word is written as two bytes, most significant first.
+void object_writer::end_line()
+{
+  static const char hex[] = "0123456789ABCDEF";
+  if (count == 0) return;
+
+  char  text[4 + 6 * line_words + 1];
+  char *p = text;
+  *p++ = '.'; *p++ = 'O'; *p++ = 'J';
+  for (int i = 0; i < count; ++i) {
+    *p++ = ' ';
+    *p++ = hex[(words[i] >> 12) & 0xF];
+    *p++ = hex[(words[i] >>  8) & 0xF];
+    *p++ = ' ';
+    *p++ = hex[(words[i] >>  4) & 0xF];
+    *p++ = hex[ words[i]        & 0xF];
+  }
+  *p++ = '\n';
+  out.write(text, p - text);
+
+  for (std::size_t i = 0; i < relocations.size(); ++i) {
+    out << ".Reloc " << static_cast<long>(relocations[i]) << '\n';
+  }
+  relocations.clear();
+  count = 0;
+}
+
+
+// Adds the extra word of an immediate or indirect operand.
+static void write_operand(object_writer &object,
+                          const machine_operand &op,
+                          const function_layout &layout)
+{
+  if (op.size() == 0) return;
+  switch (op.kind) {
+  case machine_operand::NUMBER:
+    object.word(static_cast<unsigned>(op.number));
+    break;
+  case machine_operand::VARIABLE: {
+    function_layout::variable_map::const_iterator p = layout.variables.find(op.name);
+    object.address(p != layout.variables.end() ? p->second : 0);
+    break;
+  }
+  case machine_operand::LABEL:
+    object.address(layout.labels[op.number]);
+    break;
+  }
+}
+
+
+static void write_instruction(object_writer &object,
+                              const instruction &i,
+                              const function_layout &layout)
+{
+  object.word(i.encoding());
+  write_operand(object, i.first, layout);
+  write_operand(object, i.second, layout);
+  object.end_line();
+}
+
+
+// The object data is laid out like the assembly language output: a jump to the start of the
+// code, the variables of each function, the code that sets up the stack, and then the code of
+// each function in source order.
+//
+void write_object(code_buffer &out, const translation_unit &unit)
+{
+  const std::size_t function_count = unit.functions.size();
+  std::vector<function_layout> layouts(function_count);
+
+  // Find the offset of every variable and label.
+  instruction entry = { JMP, immediate(0), no_operand() };
+  instruction stack_setup = { COPY, immediate(0x8000), reg(7) };
+  unsigned offset = entry.size();
+  for (std::size_t f = 0; f < function_count; ++f) {
+    std::vector<const symbol_attrs *> variables = declared_variables(unit.functions[f]->symbols);
+    for (std::size_t v = 0; v < variables.size(); ++v) {
+      layouts[f].variables[variables[v]->name] = offset;
+      offset += storage_size(*variables[v]);
+    }
+  }
+  unsigned code_start = offset;
+  offset += stack_setup.size();
+  for (std::size_t f = 0; f < function_count; ++f) {
+    const function_unit &function = *unit.functions[f];
+    const std::vector<instruction> &code = function.code->instructions();
+    layouts[f].start = offset;
+    layouts[f].labels.assign(function.label_count, 0);
+    for (std::vector<instruction>::const_iterator p = code.begin(); p != code.end(); ++p) {
+      if (p->op == LABEL) layouts[f].labels[p->first.number] = offset;
+      offset += p->size();
+    }
+  }
+
+  out << "# Object code generated by vocal compiler." << '\n'
+      << ".Version 1.0" << '\n'
+      << ".Size 16" << '\n';
+  for (std::size_t f = 0; f < function_count; ++f) {
+    out << ".Public " << unit.functions[f]->name << ' ' << static_cast<long>(layouts[f].start)
+        << '\n';
+  }
+
+  object_writer object(out);
+  object.word(entry.encoding());
+  object.address(code_start);
+  object.end_line();
+
+  // Variables start out as zero.
+  for (unsigned i = entry.size(); i < code_start; ++i) {
+    object.word(0);
+  }
+  object.end_line();
+
+  function_layout no_layout;
+  write_instruction(object, stack_setup, no_layout);
+
+  int removed = 0;
+  for (std::size_t f = 0; f < function_count; ++f) {
+    const function_unit &function = *unit.functions[f];
+    const std::vector<instruction> &code = function.code->instructions();
+    if (function_count > 1) out << "# Function " << function.name << '\n';
+    for (std::vector<instruction>::const_iterator p = code.begin(); p != code.end(); ++p) {
+      if (p->op == LABEL || p->op == DELETED) continue;
+      write_instruction(object, *p, layouts[f]);
+    }
+    removed += function.removed;
+  }
+  out << "# Peephole optimizer removed " << removed << " instructions." << '\n';
+}
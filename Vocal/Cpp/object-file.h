@@ -0,0 +1,31 @@
+/****************************************************************************
+FILE      : object-file.h
+SUBJECT   : Declaration of the OJ object file writer.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+With --emit=oj the compiler encodes its instructions itself and writes an
+OJ object file (see www/oj.xhtml) instead of assembly language for VAS.
+Labels and variables are resolved to offsets directly from the
+instruction lists, so no label names are ever formatted or parsed. The
+memory image is the one the assembler would make from the assembly
+language output with ORG 0. Every word holding an address is listed in
+a .Reloc directive and every function is listed in a .Public directive.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef OBJECT_FILE_H
+#define OBJECT_FILE_H
+
+#include "code-buffer.h"
+#include "translation-unit.h"
+
+// Writes the compiled functions of a translation unit as an OJ object file.
+void write_object(code_buffer &out, const translation_unit &unit);
+
+#endif
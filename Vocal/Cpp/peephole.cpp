@@ -0,0 +1,508 @@
+/****************************************************************************
+FILE      : peephole.cpp
+SUBJECT   : Implementation of the peephole optimizer.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Several rules only apply when a register or flag is not used afterward.
+That is decided by scanning forward from the instruction, following jumps,
+until the resource is overwritten (it's dead) or read (it's live). The
+scan gives up and assumes the resource is live if it goes on too long.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "peephole.h"
+
+// Resources tracked by the liveness scan. Registers are 0 through 7.
+const int CARRY_FLAG = 8;
+const int ZERO_FLAG  = 9;
+
+// The liveness scan looks at no more than this many instructions.
+const int scan_limit = 64;
+
+// The position of a label that isn't defined.
+const std::size_t no_position = static_cast<std::size_t>(-1);
+
+// Several functions may be optimized at once, so the state of each optimization is kept
+// per thread.
+static thread_local std::vector<instruction> *program;   // The instructions being optimized.
+// Labels are numbered consecutively so these are indexed by label number.
+static thread_local std::vector<std::size_t> label_position;   // Index of the label's definition.
+static thread_local std::vector<int> label_references;         // Number of times the label is used.
+
+
+//
+// Information about instructions
+//
+
+static bool is_label_reference(const machine_operand &op)
+{
+  return op.mode == machine_operand::IMMEDIATE && op.kind == machine_operand::LABEL;
+}
+
+static bool is_register(const machine_operand &op, int number)
+{
+  return op.mode == machine_operand::REGISTER && op.number == number;
+}
+
+// Returns true if the operand refers to the register in any way.
+static bool mentions(const machine_operand &op, int number)
+{
+  return (op.mode == machine_operand::REGISTER ||
+          op.mode == machine_operand::REGISTER_INDIRECT) && op.number == number;
+}
+
+static bool is_conditional_jump(opcode op)
+{
+  return op == JZ || op == JNZ || op == JC || op == JNC;
+}
+
+// Returns true if the instruction reads the given resource.
+static bool reads(const instruction &i, int resource)
+{
+  switch (resource) {
+  case CARRY_FLAG:
+    return i.op == ADD || i.op == SUB || i.op == JC || i.op == JNC;
+  case ZERO_FLAG:
+    return i.op == JZ || i.op == JNZ;
+  }
+
+  if (i.first.mode  == machine_operand::REGISTER_INDIRECT && i.first.number  == resource) return true;
+  if (i.second.mode == machine_operand::REGISTER_INDIRECT && i.second.number == resource) return true;
+  if (resource == 7 && (i.op == PUSH || i.op == POP)) return true;
+
+  switch (i.op) {
+  case POP:
+    return false;
+  case COPY:
+    // The destination of a copy is only written.
+    return is_register(i.first, resource);
+  default:
+    return is_register(i.first, resource) || is_register(i.second, resource);
+  }
+}
+
+// Returns true if the instruction overwrites the given resource.
+static bool writes(const instruction &i, int resource)
+{
+  switch (resource) {
+  case CARRY_FLAG:
+    switch (i.op) {
+    case ADD: case SUB: case CMP: case SHL: case SHR: case RTL: case RTR: case STC: case CLC:
+      return true;
+    default:
+      return false;
+    }
+  case ZERO_FLAG:
+    switch (i.op) {
+    case ADD: case SUB: case CMP: case AND: case OR: case XOR:
+    case INC: case DEC: case SHL: case SHR: case RTL: case RTR:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  switch (operand_count(i.op)) {
+  case 1:
+    return i.op != PUSH && is_register(i.first, resource);
+  case 2:
+    return i.op != CMP && is_register(i.second, resource);
+  }
+  return false;
+}
+
+// Returns true if the resource might be read after instruction 'after' executes.
+static bool is_live(std::size_t after, int resource)
+{
+  std::vector<std::size_t> pending(1, after + 1);
+  std::vector<std::size_t> visited;
+  int budget = scan_limit;
+
+  while (!pending.empty()) {
+    std::size_t position = pending.back();
+    pending.pop_back();
+
+    for (;;) {
+      if (position >= program->size() || --budget < 0) return true;
+
+      const instruction &i = (*program)[position];
+      if (i.op == DELETED) {
+        ++position;
+        continue;
+      }
+      if (i.op == LABEL) {
+        bool seen = false;
+        for (std::size_t k = 0; k < visited.size(); ++k) {
+          if (visited[k] == position) seen = true;
+        }
+        if (seen) break;
+        visited.push_back(position);
+        ++position;
+        continue;
+      }
+
+      if (reads(i, resource)) return true;
+      if (writes(i, resource) || i.op == HALT) break;
+      if (i.op == CALL || i.op == RET || i.op == RETI) return true;
+
+      if (i.op == JMP || is_conditional_jump(i.op)) {
+        if (!is_label_reference(i.first)) return true;
+        std::size_t target = label_position[i.first.number];
+        if (target == no_position) return true;
+        if (i.op == JMP) {
+          position = target;
+          continue;
+        }
+        pending.push_back(target);
+      }
+      ++position;
+    }
+  }
+  return false;
+}
+
+
+//
+// Editing the instruction list
+//
+
+static void count_references(const instruction &i, int delta)
+{
+  if (is_label_reference(i.first) && i.op != LABEL) label_references[i.first.number] += delta;
+  if (is_label_reference(i.second)) label_references[i.second.number] += delta;
+}
+
+static void remove(std::size_t position)
+{
+  count_references((*program)[position], -1);
+  (*program)[position].op = DELETED;
+}
+
+static void replace(std::size_t position, const instruction &replacement)
+{
+  count_references((*program)[position], -1);
+  (*program)[position] = replacement;
+  count_references(replacement, +1);
+}
+
+// Returns the position of the next instruction (or label) that hasn't been deleted.
+static std::size_t next(std::size_t position)
+{
+  do {
+    ++position;
+  } while (position < program->size() && (*program)[position].op == DELETED);
+  return position;
+}
+
+// Fetches the instruction at a position, or a NOP past the end.
+static instruction at(std::size_t position)
+{
+  if (position < program->size()) return (*program)[position];
+  instruction none = { NOP, no_operand(), no_operand() };
+  return none;
+}
+
+
+//
+// The rules. Each one looks at the instructions starting at a position and returns true if it
+// changed them.
+//
+
+// push A / pop B  =>  copy A, B (or nothing if A and B are the same).
+static bool push_pop(std::size_t position)
+{
+  instruction first = at(position);
+  std::size_t second_position = next(position);
+  instruction second = at(second_position);
+
+  if (first.op != PUSH || second.op != POP) return false;
+  if (mentions(first.first, 7) || mentions(second.first, 7)) return false;
+
+  if (first.first != second.first) {
+    instruction copy = { COPY, first.first, second.first };
+    replace(second_position, copy);
+  }
+  else {
+    remove(second_position);
+  }
+  remove(position);
+  return true;
+}
+
+// jmp L / L:  =>  L:  (also for conditional jumps, with any labels in between).
+static bool jump_to_next(std::size_t position)
+{
+  instruction jump = at(position);
+  if ((jump.op != JMP && !is_conditional_jump(jump.op)) || !is_label_reference(jump.first)) {
+    return false;
+  }
+
+  for (std::size_t p = next(position); at(p).op == LABEL; p = next(p)) {
+    if (at(p).first.number == jump.first.number) {
+      remove(position);
+      return true;
+    }
+  }
+  return false;
+}
+
+// jz L1 / jmp L2 / L1:  =>  jnz L2 / L1:  (and likewise for the other conditions).
+static bool branch_over_jump(std::size_t position)
+{
+  instruction branch = at(position);
+  std::size_t jump_position = next(position);
+  instruction jump = at(jump_position);
+  instruction target = at(next(jump_position));
+
+  if (!is_conditional_jump(branch.op) || jump.op != JMP || target.op != LABEL) return false;
+  if (!is_label_reference(branch.first) || branch.first.number != target.first.number) {
+    return false;
+  }
+
+  instruction inverted = { NOP, jump.first, no_operand() };
+  switch (branch.op) {
+  case JZ:  inverted.op = JNZ; break;
+  case JNZ: inverted.op = JZ;  break;
+  case JC:  inverted.op = JNC; break;
+  case JNC: inverted.op = JC;  break;
+  default: return false;
+  }
+  replace(position, inverted);
+  remove(jump_position);
+  return true;
+}
+
+// Instructions after jmp or halt can't be reached unless they are labeled.
+static bool unreachable(std::size_t position)
+{
+  opcode op = at(position).op;
+  if (op != JMP && op != HALT) return false;
+
+  bool changed = false;
+  for (std::size_t p = next(position); p < program->size() && at(p).op != LABEL; p = next(p)) {
+    remove(p);
+    changed = true;
+  }
+  return changed;
+}
+
+// Labels that are never used can go. This lets the other rules match across them.
+static bool unused_label(std::size_t position)
+{
+  instruction l = at(position);
+  if (l.op != LABEL || label_references[l.first.number] != 0) return false;
+  remove(position);
+  return true;
+}
+
+// clc is useless if the carry is overwritten before it is read (for example by shl, shr, rtl,
+// rtr, cmp, or another clc).
+//
+static bool dead_clc(std::size_t position)
+{
+  if (at(position).op != CLC || is_live(position, CARRY_FLAG)) return false;
+  remove(position);
+  return true;
+}
+
+// inc X / dec X  =>  nothing, provided the zero flag they set isn't used.
+static bool inc_dec(std::size_t position)
+{
+  instruction first = at(position);
+  std::size_t second_position = next(position);
+  instruction second = at(second_position);
+
+  if (!((first.op == INC && second.op == DEC) || (first.op == DEC && second.op == INC))) {
+    return false;
+  }
+  if (first.first != second.first || is_live(second_position, ZERO_FLAG)) return false;
+  remove(position);
+  remove(second_position);
+  return true;
+}
+
+// copy X, X  =>  nothing.
+static bool self_copy(std::size_t position)
+{
+  instruction copy = at(position);
+  if (copy.op != COPY || copy.first != copy.second) return false;
+  remove(position);
+  return true;
+}
+
+// copy S, rA / op rA, D  =>  op S, D  when rA isn't used afterward. Also for push rA and for
+// cmp X, rA (where rA is only read).
+//
+static bool forward_copy(std::size_t position)
+{
+  instruction copy = at(position);
+  if (copy.op != COPY || copy.second.mode != machine_operand::REGISTER) return false;
+  int a = copy.second.number;
+  if (mentions(copy.first, a)) return false;
+
+  std::size_t user_position = next(position);
+  instruction user = at(user_position);
+  instruction rewritten = user;
+
+  switch (user.op) {
+  case COPY: case ADD: case SUB: case CMP: case AND: case OR: case XOR:
+    if (is_register(user.first, a) && !mentions(user.second, a)) {
+      rewritten.first = copy.first;
+    }
+    else if (user.op == CMP && is_register(user.second, a) && !mentions(user.first, a)) {
+      rewritten.second = copy.first;
+    }
+    else {
+      return false;
+    }
+    break;
+  case PUSH:
+    if (!is_register(user.first, a)) return false;
+    rewritten.first = copy.first;
+    break;
+  default:
+    return false;
+  }
+
+  if (is_live(user_position, a)) return false;
+  replace(user_position, rewritten);
+  remove(position);
+  return true;
+}
+
+// copy M, rA / [clc] / op S, rA / copy rA, M  =>  [clc] / op S, M  when rA isn't used
+// afterward. This updates a variable in place.
+//
+static bool update_in_place(std::size_t position)
+{
+  instruction load = at(position);
+  if (load.op != COPY || load.second.mode != machine_operand::REGISTER) return false;
+  if (load.first.mode != machine_operand::INDIRECT &&
+      load.first.mode != machine_operand::REGISTER_INDIRECT) return false;
+  int a = load.second.number;
+  if (mentions(load.first, a)) return false;
+
+  std::size_t op_position = next(position);
+  if (at(op_position).op == CLC) op_position = next(op_position);
+  instruction op = at(op_position);
+  std::size_t store_position = next(op_position);
+  instruction store = at(store_position);
+
+  if (store.op != COPY || !is_register(store.first, a) || store.second != load.first) return false;
+
+  instruction rewritten = op;
+  switch (op.op) {
+  case ADD: case SUB: case AND: case OR: case XOR:
+    if (!is_register(op.second, a) || mentions(op.first, a)) return false;
+    rewritten.second = load.first;
+    break;
+  case INC: case DEC: case SHL: case SHR: case RTL: case RTR:
+    if (!is_register(op.first, a)) return false;
+    rewritten.first = load.first;
+    break;
+  default:
+    return false;
+  }
+
+  if (is_live(store_position, a)) return false;
+  replace(op_position, rewritten);
+  remove(position);
+  remove(store_position);
+  return true;
+}
+
+// clc / add 1, X  =>  inc X  (and sub 1 => dec)  when the carry isn't used afterward.
+static bool add_one(std::size_t position)
+{
+  std::size_t op_position = next(position);
+  instruction op = at(op_position);
+
+  if (at(position).op != CLC || (op.op != ADD && op.op != SUB)) return false;
+  if (op.first.mode != machine_operand::IMMEDIATE ||
+      op.first.kind != machine_operand::NUMBER || op.first.number != 1) return false;
+  if (is_live(op_position, CARRY_FLAG)) return false;
+
+  instruction step = { op.op == ADD ? INC : DEC, op.second, no_operand() };
+  replace(op_position, step);
+  remove(position);
+  return true;
+}
+
+static const struct {
+  const char *name;
+  bool (*apply)(std::size_t position);
+} rules[] = {
+  { "push/pop",           push_pop         },
+  { "jump to next",       jump_to_next     },
+  { "branch over jump",   branch_over_jump },
+  { "unreachable code",   unreachable      },
+  { "unused label",       unused_label     },
+  { "self copy",          self_copy        },
+  { "inc/dec",            inc_dec          },
+  { "forward copy",       forward_copy     },
+  { "update in place",    update_in_place  },
+  { "add one",            add_one          },
+  { "dead clc",           dead_clc         }
+};
+
+
+// Records where each label is and how many times it is used.
+static void index_labels()
+{
+  int label_count = 0;
+  for (std::size_t p = 0; p < program->size(); ++p) {
+    const instruction &i = (*program)[p];
+    if (is_label_reference(i.first) && i.first.number >= label_count) label_count = i.first.number + 1;
+    if (is_label_reference(i.second) && i.second.number >= label_count) label_count = i.second.number + 1;
+  }
+  label_position.assign(label_count, no_position);
+  label_references.assign(label_count, 0);
+
+  for (std::size_t p = 0; p < program->size(); ++p) {
+    const instruction &i = (*program)[p];
+    if (i.op == LABEL) {
+      label_position[i.first.number] = p;
+    }
+    else {
+      count_references(i, +1);
+    }
+  }
+}
+
+static void compact()
+{
+  std::size_t kept = 0;
+  for (std::size_t p = 0; p < program->size(); ++p) {
+    if ((*program)[p].op != DELETED) (*program)[kept++] = (*program)[p];
+  }
+  program->resize(kept);
+}
+
+
+int peephole_optimize(instruction_list &list)
+{
+  program = &list.instructions();
+  int original_count = list.instruction_count();
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    index_labels();
+    for (std::size_t p = 0; p < program->size(); ++p) {
+      for (std::size_t r = 0; r < sizeof(rules) / sizeof(rules[0]); ++r) {
+        if ((*program)[p].op == DELETED) break;
+        if (rules[r].apply(p)) changed = true;
+      }
+    }
+    compact();
+  }
+
+  program = 0;
+  return original_count - list.instruction_count();
+}
@@ -0,0 +1,27 @@
+/****************************************************************************
+FILE      : peephole.h
+SUBJECT   : Declaration of the peephole optimizer.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+The peephole optimizer rewrites short sequences of generated instructions
+into cheaper equivalents. Each rule in its table recognizes a pattern and
+replaces it. The rules are applied over the whole instruction list until
+none of them match.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include "instruction-list.h"
+
+// Optimizes the instructions in place. Returns the number of instructions removed.
+int peephole_optimize(instruction_list &list);
+
+#endif
@@ -0,0 +1,69 @@
+/****************************************************************************
+FILE      : source-file.cpp
+SUBJECT   : Implementation of a read only view of a source file.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "source-file.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+source_file::source_file()
+  : start(0), length(0), mapped(false)
+{ }
+
+
+bool source_file::open(const char *filename)
+{
+  close();
+
+  int descriptor = ::open(filename, O_RDONLY);
+  if (descriptor < 0) return false;
+
+  struct stat status;
+  if (fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+    void *mapping =
+      mmap(0, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (mapping != MAP_FAILED) {
+      ::close(descriptor);
+      start  = static_cast<const char *>(mapping);
+      length = static_cast<std::size_t>(status.st_size);
+      mapped = true;
+      return true;
+    }
+  }
+
+  // Fall back to reading the whole file.
+  char buffer[16 * 1024];
+  ssize_t count;
+  while ((count = read(descriptor, buffer, sizeof(buffer))) > 0) {
+    copy.insert(copy.end(), buffer, buffer + count);
+  }
+  ::close(descriptor);
+  if (count < 0) {
+    copy.clear();
+    return false;
+  }
+  start  = copy.empty() ? "" : &copy[0];
+  length = copy.size();
+  return true;
+}
+
+
+void source_file::close()
+{
+  if (mapped) munmap(const_cast<char *>(start), length);
+  copy.clear();
+  start  = 0;
+  length = 0;
+  mapped = false;
+}
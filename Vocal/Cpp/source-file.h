@@ -0,0 +1,52 @@
+/****************************************************************************
+FILE      : source-file.h
+SUBJECT   : Declaration of a read only view of a source file.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+The compiler reads a source file by mapping it into memory. The lexer
+scans the mapped bytes directly and tokens refer to them by offset, so
+the text is never copied. If the file can't be mapped (for example, if it
+is empty or isn't a regular file) it is read into an ordinary buffer
+instead.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef SOURCE_FILE_H
+#define SOURCE_FILE_H
+
+#include <cstddef>
+#include <vector>
+
+class source_file {
+public:
+  source_file();
+  ~source_file() { close(); }
+
+  // Makes the contents of the named file available. Returns false if the file can't be read.
+  bool open(const char *filename);
+
+  // Releases the contents. The text is no longer valid afterward.
+  void close();
+
+  // The contents of the file. The text is not null terminated.
+  const char *text() const { return start; }
+  std::size_t size() const { return length; }
+
+private:
+  const char       *start;
+  std::size_t       length;
+  bool              mapped;    // True if start points at a mapping rather than into copy.
+  std::vector<char> copy;
+
+  // Copying is not supported.
+  source_file(const source_file &);
+  source_file &operator=(const source_file &);
+};
+
+#endif
@@ -0,0 +1,128 @@
+/****************************************************************************
+FILE      : statistics.cpp
+SUBJECT   : Implementation of the compiler's timers and counters.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "statistics.h"
+#include <iomanip>
+#include <iostream>
+
+thread_local statistics *stats = 0;
+
+static const char *const pass_names[PASS_COUNT] = {
+  "cache", "lex", "parse", "symbols", "bind", "ir", "values", "select", "peephole", "output"
+};
+
+static const char *const phase_names[PHASE_COUNT] = {
+  "parse", "compile", "write", "total"
+};
+
+static const char *const node_names[NODE_KIND_COUNT] = {
+  "and", "or", "relational", "add", "sub", "mul", "div", "shift", "num", "id", "arrayref",
+  "block", "if", "while", "return", "assignment", "arrayassign"
+};
+
+// The counters other than the node counts, in the order they are reported.
+static const struct {
+  const char *name;
+  long statistics::*count;
+} counters[] = {
+  { "files",        &statistics::files        },
+  { "cache_hits",   &statistics::cache_hits   },
+  { "functions",    &statistics::functions    },
+  { "tokens",       &statistics::tokens       },
+  { "labels",       &statistics::labels       },
+  { "blocks",       &statistics::blocks       },
+  { "redundant",    &statistics::redundant    },
+  { "instructions", &statistics::instructions },
+  { "removed",      &statistics::removed      },
+  { "bytes",        &statistics::bytes        }
+};
+
+static const int counter_count = sizeof(counters) / sizeof(counters[0]);
+
+static double seconds(long long nanoseconds)
+{
+  return nanoseconds / 1.0e9;
+}
+
+
+statistics::statistics()
+{
+  for (int i = 0; i < PASS_COUNT; ++i) pass_time[i] = 0;
+  for (int i = 0; i < PHASE_COUNT; ++i) phase_time[i] = 0;
+  for (int i = 0; i < NODE_KIND_COUNT; ++i) nodes[i] = 0;
+  for (int i = 0; i < counter_count; ++i) this->*counters[i].count = 0;
+}
+
+
+void statistics::add(const statistics &other)
+{
+  for (int i = 0; i < PASS_COUNT; ++i) pass_time[i] += other.pass_time[i];
+  for (int i = 0; i < PHASE_COUNT; ++i) phase_time[i] += other.phase_time[i];
+  for (int i = 0; i < NODE_KIND_COUNT; ++i) nodes[i] += other.nodes[i];
+  for (int i = 0; i < counter_count; ++i) this->*counters[i].count += other.*counters[i].count;
+}
+
+
+void statistics::write_text(std::ostream &out) const
+{
+  std::ios::fmtflags flags = out.flags();
+  out << std::fixed << std::setprecision(6);
+
+  out << "Pass times (seconds, summed over threads):\n";
+  for (int i = 0; i < PASS_COUNT; ++i) {
+    out << "  " << std::left << std::setw(14) << pass_names[i]
+        << std::right << std::setw(12) << seconds(pass_time[i]) << '\n';
+  }
+  out << "Phase times (seconds, wall clock):\n";
+  for (int i = 0; i < PHASE_COUNT; ++i) {
+    out << "  " << std::left << std::setw(14) << phase_names[i]
+        << std::right << std::setw(12) << seconds(phase_time[i]) << '\n';
+  }
+  out << "Counts:\n";
+  for (int i = 0; i < counter_count; ++i) {
+    out << "  " << std::left << std::setw(14) << counters[i].name
+        << std::right << std::setw(12) << this->*counters[i].count << '\n';
+  }
+  out << "Syntax tree nodes:\n";
+  for (int i = 0; i < NODE_KIND_COUNT; ++i) {
+    out << "  " << std::left << std::setw(14) << node_names[i]
+        << std::right << std::setw(12) << nodes[i] << '\n';
+  }
+  out.flags(flags);
+}
+
+
+void statistics::write_json(std::ostream &out) const
+{
+  std::ios::fmtflags flags = out.flags();
+  out << std::fixed << std::setprecision(6);
+
+  out << "{\n  \"passes\": {";
+  for (int i = 0; i < PASS_COUNT; ++i) {
+    out << (i ? ", " : "") << '"' << pass_names[i] << "\": " << seconds(pass_time[i]);
+  }
+  out << "},\n  \"phases\": {";
+  for (int i = 0; i < PHASE_COUNT; ++i) {
+    out << (i ? ", " : "") << '"' << phase_names[i] << "\": " << seconds(phase_time[i]);
+  }
+  out << "},\n  \"counts\": {";
+  for (int i = 0; i < counter_count; ++i) {
+    out << (i ? ", " : "") << '"' << counters[i].name << "\": " << this->*counters[i].count;
+  }
+  out << "},\n  \"nodes\": {";
+  for (int i = 0; i < NODE_KIND_COUNT; ++i) {
+    out << (i ? ", " : "") << '"' << node_names[i] << "\": " << nodes[i];
+  }
+  out << "}\n}\n";
+  out.flags(flags);
+}
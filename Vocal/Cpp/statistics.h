@@ -0,0 +1,115 @@
+/****************************************************************************
+FILE      : statistics.h
+SUBJECT   : Declaration of the compiler's timers and counters.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+With --time-passes or --stats=json the compiler measures how long each
+of its passes takes and counts what it builds and emits. Every job (a
+file being parsed or written, a function being compiled) collects its
+own statistics and they are added together at the end, so no locking is
+needed. When statistics aren't wanted the current statistics pointer is
+null and the timers and counters do nothing. The lexer is timed token by
+token, which makes the run noticeably slower when statistics are wanted.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <chrono>
+#include <iosfwd>
+
+// The timed passes. Their times are summed over all threads.
+enum pass_type {
+  CACHE_PASS,     // Hashing source files and looking up or storing cache entries.
+  LEX_PASS,       // Scanning tokens.
+  PARSE_PASS,     // yyparse(), not counting the time spent in the lexer and symbol table.
+  SYMBOL_PASS,    // Interning identifiers.
+  BIND_PASS,      // Resolving names in the syntax tree.
+  IR_PASS,        // Simplifying expressions and translating them into intermediate code.
+  VALUE_PASS,     // Value numbering.
+  SELECT_PASS,    // Instruction selection.
+  PEEPHOLE_PASS,  // The peephole optimizer.
+  OUTPUT_PASS,    // Formatting and writing output files.
+  PASS_COUNT
+};
+
+// The phases of a run. Each phase is timed by the wall clock.
+enum phase_type { PARSE_PHASE, COMPILE_PHASE, WRITE_PHASE, TOTAL_PHASE, PHASE_COUNT };
+
+// The kinds of syntax tree nodes.
+enum node_kind {
+  AND_NODE, OR_NODE, RELATIONAL_NODE, ADD_NODE, SUB_NODE, MUL_NODE, DIV_NODE, SHIFT_NODE,
+  NUM_NODE, ID_NODE, ARRAYREF_NODE, BLOCK_NODE, IF_NODE, WHILE_NODE, RETURN_NODE,
+  ASSIGNMENT_NODE, ARRAYASSIGN_NODE, NODE_KIND_COUNT
+};
+
+struct statistics {
+  long long pass_time[PASS_COUNT];    // Nanoseconds.
+  long long phase_time[PHASE_COUNT];  // Nanoseconds. Only set in the final totals.
+  long      nodes[NODE_KIND_COUNT];   // Nodes created, including those made by simplification.
+  long      files;
+  long      cache_hits;
+  long      functions;
+  long      tokens;
+  long      labels;                   // Labels returned by next_label().
+  long      blocks;                   // Basic blocks in the intermediate code.
+  long      redundant;                // Intermediate instructions removed by value numbering.
+  long      instructions;             // Instructions generated, before peephole optimization.
+  long      removed;                  // Instructions removed by the peephole optimizer.
+  long      bytes;                    // Bytes written to output files, not counting cache hits.
+
+  statistics();
+
+  // Adds the counts and times of another job to these.
+  void add(const statistics &other);
+
+  // Writes the statistics as a table meant for people to read.
+  void write_text(std::ostream &out) const;
+
+  // Writes the statistics as a JSON object.
+  void write_json(std::ostream &out) const;
+};
+
+// The statistics of the job running on this thread, or null if statistics aren't wanted.
+extern thread_local statistics *stats;
+
+inline void count_node(node_kind kind)
+{
+  if (stats) ++stats->nodes[kind];
+}
+
+// Returns the nanoseconds elapsed since the given time.
+inline long long nanoseconds_since(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+// Adds the time from its construction to its destruction to a pass.
+class pass_timer {
+public:
+  explicit pass_timer(pass_type p)
+    : pass(p), running(stats != 0)
+    { if (running) start = std::chrono::steady_clock::now(); }
+
+  ~pass_timer()
+    { if (running) stats->pass_time[pass] += nanoseconds_since(start); }
+
+private:
+  pass_type pass;
+  bool      running;
+  std::chrono::steady_clock::time_point start;
+
+  // Copying is not supported.
+  pass_timer(const pass_timer &);
+  pass_timer &operator=(const pass_timer &);
+};
+
+#endif
@@ -0,0 +1,88 @@
+/****************************************************************************
+FILE      : symbol-table.cpp
+SUBJECT   : Implementation of the table of interned identifiers.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "symbol-table.h"
+#include <cstring>
+#include <new>
+
+thread_local symbol_table *symbols = 0;
+
+// FNV-1a. Identifiers are short so a simple byte at a time hash is good enough.
+static unsigned hash_of(const char *text, std::size_t length)
+{
+  unsigned hash = 2166136261U;
+  for (std::size_t i = 0; i < length; ++i) {
+    hash ^= static_cast<unsigned char>(text[i]);
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+
+symbol_table::symbol_table()
+  : storage(16 * 1024), buckets(64, -1)
+{ }
+
+
+int symbol_table::intern(const char *text, std::size_t length)
+{
+  unsigned hash = hash_of(text, length);
+  std::size_t mask = buckets.size() - 1;
+  std::size_t i = hash & mask;
+
+  while (buckets[i] != -1) {
+    const symbol *existing = symbols[buckets[i]];
+    if (existing->hash == hash && existing->length == length &&
+        std::memcmp(existing->attrs.name, text, length) == 0) {
+      return buckets[i];
+    }
+    i = (i + 1) & mask;
+  }
+
+  symbol *new_symbol = new (storage.allocate(sizeof(symbol))) symbol;
+  new_symbol->attrs.name         = storage.copy_string(text, length);
+  new_symbol->attrs.vartype      = tERROR;
+  new_symbol->attrs.num_elements = 0;
+  new_symbol->length             = length;
+  new_symbol->hash               = hash;
+  new_symbol->declared           = false;
+
+  int id = static_cast<int>(symbols.size());
+  symbols.push_back(new_symbol);
+  buckets[i] = id;
+
+  // Keep the table no more than half full so that probe sequences stay short.
+  if (symbols.size() * 2 > buckets.size()) grow();
+  return id;
+}
+
+
+void symbol_table::declare(int id, symbol_type type, int num_elements)
+{
+  symbols[id]->attrs.vartype      = type;
+  symbols[id]->attrs.num_elements = num_elements;
+  symbols[id]->declared           = true;
+}
+
+
+void symbol_table::grow()
+{
+  buckets.assign(buckets.size() * 2, -1);
+  std::size_t mask = buckets.size() - 1;
+
+  for (std::size_t id = 0; id < symbols.size(); ++id) {
+    std::size_t i = symbols[id]->hash & mask;
+    while (buckets[i] != -1) i = (i + 1) & mask;
+    buckets[i] = static_cast<int>(id);
+  }
+}
@@ -0,0 +1,81 @@
+/****************************************************************************
+FILE      : symbol-table.h
+SUBJECT   : Declaration of the table of interned identifiers.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+The lexer interns every identifier as it is scanned. Each distinct name
+gets a small integer ID and is stored once, in an arena owned by the
+table. The parser records declarations against those IDs. After parsing,
+a binding pass over the syntax tree replaces each reference with a
+pointer to the symbol's attributes, so code generation never looks at a
+name except to print it.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <cstddef>
+#include <vector>
+#include "arena.h"
+
+enum symbol_type { tINT, tLONG, tINTARRAY, tLONGARRAY , tERROR};
+
+// Make a structure to store all of the attributes of the variables.
+struct symbol_attrs {
+  const char *name;
+  symbol_type vartype;
+  int num_elements;
+};
+
+class symbol_table {
+public:
+  symbol_table();
+
+  // Returns the ID of the identifier text[0 .. length - 1], adding it to the table if it is
+  // new. IDs are assigned consecutively from zero.
+  //
+  int intern(const char *text, std::size_t length);
+
+  // Returns the name of a symbol. The name stays valid as long as the table does.
+  const char *name(int id) const { return symbols[id]->attrs.name; }
+
+  // Records the declaration of a symbol. A later declaration replaces an earlier one.
+  void declare(int id, symbol_type type, int num_elements);
+
+  // Returns the attributes of a symbol or a null pointer if it hasn't been declared.
+  const symbol_attrs *lookup(int id) const
+    { return symbols[id]->declared ? &symbols[id]->attrs : 0; }
+
+  // Returns the number of symbols. IDs run from zero up to one less than this.
+  int size() const { return static_cast<int>(symbols.size()); }
+
+private:
+  struct symbol {
+    symbol_attrs attrs;
+    std::size_t  length;
+    unsigned     hash;
+    bool         declared;
+  };
+
+  arena                 storage;    // Holds the symbols and their names.
+  std::vector<symbol *> symbols;    // Indexed by ID.
+  std::vector<int>      buckets;    // Open addressing. Holds IDs, or -1 if empty.
+
+  void grow();
+
+  // Copying is not supported.
+  symbol_table(const symbol_table &);
+  symbol_table &operator=(const symbol_table &);
+};
+
+// The symbols of the function being compiled. Each thread has its own.
+extern thread_local symbol_table *symbols;
+
+#endif
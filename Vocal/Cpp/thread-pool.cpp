@@ -0,0 +1,80 @@
+/****************************************************************************
+FILE      : thread-pool.cpp
+SUBJECT   : Implementation of a simple pool of worker threads.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "thread-pool.h"
+
+thread_pool::thread_pool(int thread_count)
+  : job(0), count(0), next(0), done(0), phase(0), stopping(false)
+{
+  // The thread calling run() is one of the threads.
+  for (int i = 1; i < thread_count; ++i) {
+    workers.push_back(std::thread(&thread_pool::work, this));
+  }
+}
+
+
+thread_pool::~thread_pool()
+{
+  {
+    std::lock_guard<std::mutex> held(lock);
+    stopping = true;
+  }
+  started.notify_all();
+  for (std::size_t i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+  }
+}
+
+
+void thread_pool::run(std::size_t job_count, const std::function<void (std::size_t)> &phase_job)
+{
+  std::unique_lock<std::mutex> held(lock);
+  job   = &phase_job;
+  count = job_count;
+  next  = 0;
+  done  = 0;
+  ++phase;
+  started.notify_all();
+
+  run_jobs(held);
+  while (done != count) finished.wait(held);
+  job = 0;
+}
+
+
+// Hands out jobs one at a time until there are none left. Jobs are few and large (a file or a
+// function each), so taking the lock for every one costs nothing worth measuring.
+//
+void thread_pool::run_jobs(std::unique_lock<std::mutex> &held)
+{
+  while (next < count) {
+    std::size_t index = next++;
+    held.unlock();
+    (*job)(index);
+    held.lock();
+    if (++done == count) finished.notify_all();
+  }
+}
+
+
+void thread_pool::work()
+{
+  std::unique_lock<std::mutex> held(lock);
+  unsigned seen = 0;
+  for (;;) {
+    while (!stopping && phase == seen) started.wait(held);
+    if (stopping) return;
+    seen = phase;
+    run_jobs(held);
+  }
+}
@@ -0,0 +1,65 @@
+/****************************************************************************
+FILE      : thread-pool.h
+SUBJECT   : Declaration of a simple pool of worker threads.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+The compiler works in phases (parse every file, compile every function,
+write every file) and each phase is a set of independent jobs. A
+thread_pool runs the jobs of one phase at a time and waits for all of
+them to finish before the next phase starts. The threads are started
+once and reused for every phase.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class thread_pool {
+public:
+  // Jobs are run on this many threads, counting the thread that calls run(). With one thread
+  // no threads are started and run() does all the work itself.
+  //
+  explicit thread_pool(int thread_count);
+  ~thread_pool();
+
+  // Calls job(i) for every i from zero up to count - 1 and returns when all of the calls have
+  // returned. The calls happen in no particular order, possibly at the same time.
+  //
+  void run(std::size_t count, const std::function<void (std::size_t)> &job);
+
+private:
+  std::vector<std::thread> workers;
+  std::mutex               lock;
+  std::condition_variable  started;    // Signaled when a phase starts or the pool stops.
+  std::condition_variable  finished;   // Signaled when the last job of a phase is done.
+
+  // The phase being run. These are protected by lock.
+  const std::function<void (std::size_t)> *job;
+  std::size_t count;        // Number of jobs in the phase.
+  std::size_t next;         // Next job to hand out.
+  std::size_t done;         // Number of jobs that have returned.
+  unsigned    phase;        // Incremented when a phase starts.
+  bool        stopping;
+
+  void work();
+  void run_jobs(std::unique_lock<std::mutex> &held);
+
+  // Copying is not supported.
+  thread_pool(const thread_pool &);
+  thread_pool &operator=(const thread_pool &);
+};
+
+#endif
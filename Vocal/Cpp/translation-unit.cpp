@@ -0,0 +1,70 @@
+/****************************************************************************
+FILE      : translation-unit.cpp
+SUBJECT   : Implementation of the compilation state of a source file.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "translation-unit.h"
+#include "instruction-list.h"
+#include <algorithm>
+#include <cstring>
+
+function_unit::~function_unit()
+{
+  delete code;
+}
+
+
+translation_unit::~translation_unit()
+{
+  for (std::size_t i = 0; i < functions.size(); ++i) {
+    delete functions[i];
+  }
+}
+
+
+function_unit *translation_unit::begin_function()
+{
+  function_unit *function = new function_unit;
+  functions.push_back(function);
+  symbols    = &function->symbols;
+  node_arena = &function->nodes;
+  return function;
+}
+
+
+static bool name_before(const symbol_attrs *left, const symbol_attrs *right)
+{
+  return std::strcmp(left->name, right->name) < 0;
+}
+
+
+std::vector<const symbol_attrs *> declared_variables(const symbol_table &scope)
+{
+  std::vector<const symbol_attrs *> variables;
+  for (int id = 0; id < scope.size(); ++id) {
+    if (scope.lookup(id) != 0) variables.push_back(scope.lookup(id));
+  }
+  std::sort(variables.begin(), variables.end(), name_before);
+  return variables;
+}
+
+
+int storage_size(const symbol_attrs &variable)
+{
+  int elements = variable.num_elements > 1 ? variable.num_elements : 1;
+  switch (variable.vartype) {
+  case tINT:       return 1;
+  case tLONG:      return 2;
+  case tINTARRAY:  return elements;
+  case tLONGARRAY: return 2 * elements;
+  default:         return 0;
+  }
+}
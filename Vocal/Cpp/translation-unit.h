@@ -0,0 +1,91 @@
+/****************************************************************************
+FILE      : translation-unit.h
+SUBJECT   : Declaration of the compilation state of a source file.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Each source file is a translation_unit and each function in it is a
+function_unit. A function is compiled independently of every other
+function: it has its own scope (symbol table), syntax tree, labels, and
+code. That lets functions be compiled at the same time on different
+threads. The per function pieces are put back together in source order
+when the output file is written.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef TRANSLATION_UNIT_H
+#define TRANSLATION_UNIT_H
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "arena.h"
+#include "node-types.h"
+#include "source-file.h"
+#include "symbol-table.h"
+
+// The parser uses these declarations too. It can't see instruction-list.h because the opcodes
+// have the same names as some of its tokens.
+//
+class instruction_list;
+
+struct function_unit {
+  std::string        name;
+  symbol_table       symbols;      // The function's scope.
+  arena              nodes;        // The syntax tree. Released after code generation.
+  stmt_node         *body;         // Null until the function has been parsed.
+  instruction_list  *code;         // Null until the function has been compiled.
+  int                label_count;  // Labels used by the code. They are numbered from zero.
+  int                removed;      // Instructions removed by the peephole optimizer.
+  std::ostringstream messages;     // Errors and warnings from code generation.
+  int                errors;       // The number of those that are errors.
+  statistics         measurements; // Collected while the function is compiled.
+
+  function_unit() : nodes(16 * 1024), body(0), code(0), label_count(0), removed(0), errors(0) { }
+  ~function_unit();
+
+private:
+  // Copying is not supported.
+  function_unit(const function_unit &);
+  function_unit &operator=(const function_unit &);
+};
+
+struct translation_unit {
+  std::string                  source_name;
+  std::string                  output_name;
+  source_file                  source;
+  std::vector<function_unit *> functions;  // In source order.
+  std::ostringstream           messages;   // Errors reading, parsing, or writing the file.
+  int                          status;     // The exit status for this file. Zero if all is well.
+  std::string                  cache_key;  // Empty unless the compile cache is in use.
+  bool                         cached;     // True if the output was taken from the cache.
+  statistics                   measurements; // Collected while the file is parsed and written.
+
+  translation_unit() : status(0), cached(false) { }
+  ~translation_unit();
+
+  // Adds a function to the end of the file and makes its scope and syntax tree the current
+  // ones (see symbols and node_arena) on the calling thread.
+  //
+  function_unit *begin_function();
+
+private:
+  // Copying is not supported.
+  translation_unit(const translation_unit &);
+  translation_unit &operator=(const translation_unit &);
+};
+
+// Returns the variables declared in a scope in the order their storage is laid out. They are
+// ordered by name so that the layout is the same on every run.
+//
+std::vector<const symbol_attrs *> declared_variables(const symbol_table &scope);
+
+// Returns the number of words of storage a variable takes. Arrays take at least one element.
+int storage_size(const symbol_attrs &variable);
+
+#endif
@@ -0,0 +1,468 @@
+/****************************************************************************
+FILE      : value-numbering.cpp
+SUBJECT   : Implementation of the value numbering optimization.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "value-numbering.h"
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// A variable's version changes every time it is stored into. Values that depend on a variable
+// are looked up with its current version, so values computed before the store aren't found.
+//
+typedef unordered_map<const char *, unsigned> version_map;
+
+// What an operand contributes to the value of an instruction.
+struct operand_key {
+  int         kind;
+  int         type;
+  int         number;   // Temporary or constant.
+  const char *name;     // Variable.
+  unsigned    version;
+
+  bool operator==(const operand_key &other) const
+    { return kind == other.kind && type == other.type && number == other.number &&
+             name == other.name && version == other.version; }
+  bool operator<(const operand_key &other) const;
+};
+
+bool operand_key::operator<(const operand_key &other) const
+{
+  if (kind   != other.kind)   return kind < other.kind;
+  if (type   != other.type)   return type < other.type;
+  if (number != other.number) return number < other.number;
+  if (name   != other.name)   return less<const char *>()(name, other.name);
+  return version < other.version;
+}
+
+// Two instructions with the same key compute the same value.
+struct value_key {
+  int         op;
+  int         type;
+  operand_key left;
+  operand_key right;
+  const char *name;     // The variable or array loaded.
+  unsigned    version;
+  int         detail;   // The relation of a comparison or the count of a shift.
+  int         region;   // Where the value can be used again, or -1 for anywhere it's known.
+
+  bool operator==(const value_key &other) const
+    { return op == other.op && type == other.type && left == other.left &&
+             right == other.right && name == other.name && version == other.version &&
+             detail == other.detail && region == other.region; }
+};
+
+struct value_key_hash {
+  size_t operator()(const value_key &k) const;
+};
+
+static size_t mix(size_t hash, size_t value)
+{
+  return (hash ^ value) * 1099511628211ULL;
+}
+
+static size_t mix(size_t hash, const operand_key &k)
+{
+  hash = mix(hash, static_cast<size_t>(k.kind));
+  hash = mix(hash, static_cast<size_t>(k.type));
+  hash = mix(hash, static_cast<size_t>(k.number));
+  hash = mix(hash, reinterpret_cast<size_t>(k.name));
+  return mix(hash, k.version);
+}
+
+size_t value_key_hash::operator()(const value_key &k) const
+{
+  size_t hash = 14695981039346656037ULL;
+  hash = mix(hash, static_cast<size_t>(k.op));
+  hash = mix(hash, static_cast<size_t>(k.type));
+  hash = mix(hash, k.left);
+  hash = mix(hash, k.right);
+  hash = mix(hash, reinterpret_cast<size_t>(k.name));
+  hash = mix(hash, k.version);
+  hash = mix(hash, static_cast<size_t>(k.detail));
+  return mix(hash, static_cast<size_t>(k.region));
+}
+
+typedef unordered_map<value_key, int, value_key_hash> value_table;
+
+// Returns true if an instruction computes its value about as quickly as its value could be
+// reloaded from memory. Instruction selection keeps values in registers only within an extended
+// block (see instruction-selection.h) and a value used elsewhere is stored and reloaded, so these
+// are only used again within the extended block computing them.
+//
+static bool cheap(const ir_instruction &i)
+{
+  return (i.op == IR_ADD || i.op == IR_SUB) && i.type == tINT &&
+         i.left.kind != ir_operand::TEMPORARY && i.right.kind != ir_operand::TEMPORARY;
+}
+
+
+//
+// Class numbering
+//
+
+// The state of the walk over the dominator tree. The values in the table and the versions of
+// the variables are those at the top of the block being numbered. Changes are logged so that
+// they can be undone when the walk leaves the blocks a block dominates.
+//
+class numbering {
+public:
+  explicit numbering(ir_function &f);
+
+  // Numbers the values of every block that can be reached and returns the number of
+  // instructions removed.
+  //
+  int run();
+
+private:
+  struct version_change {
+    const char *name;
+    unsigned    old_version;
+  };
+
+  ir_function &function;
+  vector<int>  postorder;           // Position of each block in reverse postorder, -1 if unreachable.
+  vector<int>  dominator;           // The immediate dominator of each block.
+  vector<int>  first_child;         // The dominator tree, as lists of children.
+  vector<int>  next_sibling;
+  vector<int>  visited;             // The block whose predecessors were last searched from here.
+  vector<int>  region;              // The first block of each block's extended block.
+  int          current;             // The block being numbered.
+  vector<int>  replacement;         // Indexed by temporary.
+  value_table  values;
+  version_map  versions;
+  unsigned     last_version;
+  vector<value_key>       added;    // Keys added to values, in order.
+  vector<version_change>  changed;  // Versions changed, in order.
+
+  void find_dominators();
+  void find_regions();
+  int  intersect(int first, int second) const;
+  operand_key key_of(ir_operand &op);
+  value_key key_of(ir_instruction &i);
+  void store_into(const char *name);
+  void remember(const value_key &k, int temporary);
+  void enter(int block);
+  int  number_block(ir_block &b);
+
+  // Copying is not supported.
+  numbering(const numbering &);
+  numbering &operator=(const numbering &);
+};
+
+
+numbering::numbering(ir_function &f)
+  : function(f),
+    postorder(f.block_count(), -1),
+    dominator(f.block_count(), -1),
+    first_child(f.block_count(), -1),
+    next_sibling(f.block_count(), -1),
+    visited(f.block_count(), -1),
+    region(f.block_count(), -1),
+    current(0),
+    replacement(f.temporary_count()),
+    last_version(0)
+{
+  for (int t = 0; t < f.temporary_count(); ++t) {
+    replacement[t] = t;
+  }
+}
+
+
+// Finds the immediate dominators with the iterative algorithm of Cooper, Harvey, and Kennedy.
+// The graph is walked without recursion since a long function has a great many blocks.
+//
+void numbering::find_dominators()
+{
+  vector<int> order;
+  vector<pair<int, int> > pending(1, make_pair(0, 0));  // Block and next successor to visit.
+  vector<bool> seen(function.block_count(), false);
+  seen[0] = true;
+  while (!pending.empty()) {
+    pair<int, int> &top = pending.back();
+    const ir_block &b = function.block(top.first);
+    if (top.second < b.successor_count()) {
+      int s = b.successor[top.second++];
+      if (!seen[s]) {
+        seen[s] = true;
+        pending.push_back(make_pair(s, 0));
+      }
+    }
+    else {
+      order.push_back(top.first);
+      pending.pop_back();
+    }
+  }
+
+  // Put the blocks in reverse postorder.
+  for (size_t i = 0; i < order.size() / 2; ++i) {
+    swap(order[i], order[order.size() - 1 - i]);
+  }
+  for (size_t i = 0; i < order.size(); ++i) {
+    postorder[order[i]] = static_cast<int>(i);
+  }
+
+  dominator[0] = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 1; i < order.size(); ++i) {
+      const vector<int> &predecessors = function.block(order[i]).predecessors;
+      int new_dominator = -1;
+      for (size_t p = 0; p < predecessors.size(); ++p) {
+        if (dominator[predecessors[p]] < 0) continue;
+        new_dominator = new_dominator < 0 ?
+          predecessors[p] : intersect(predecessors[p], new_dominator);
+      }
+      if (dominator[order[i]] != new_dominator) {
+        dominator[order[i]] = new_dominator;
+        changed = true;
+      }
+    }
+  }
+
+  for (size_t i = order.size() - 1; i >= 1; --i) {
+    next_sibling[order[i]] = first_child[dominator[order[i]]];
+    first_child[dominator[order[i]]] = order[i];
+  }
+}
+
+
+// A block with one predecessor laid out before it continues the extended block of that
+// predecessor, as it does in instruction selection.
+//
+void numbering::find_regions()
+{
+  const vector<int> &layout = function.layout();
+  vector<int> position(function.block_count(), -1);
+  for (size_t p = 0; p < layout.size(); ++p) {
+    position[layout[p]] = static_cast<int>(p);
+  }
+  for (size_t p = 0; p < layout.size(); ++p) {
+    int n = layout[p];
+    const vector<int> &predecessors = function.block(n).predecessors;
+    bool continues = predecessors.size() == 1 && position[predecessors[0]] >= 0 &&
+                     position[predecessors[0]] < position[n];
+    region[n] = continues ? region[predecessors[0]] : n;
+  }
+}
+
+
+int numbering::intersect(int first, int second) const
+{
+  while (first != second) {
+    while (postorder[first]  > postorder[second]) first  = dominator[first];
+    while (postorder[second] > postorder[first])  second = dominator[second];
+  }
+  return first;
+}
+
+
+operand_key numbering::key_of(ir_operand &op)
+{
+  operand_key k = { op.kind, op.type, op.number, op.name, 0 };
+  switch (op.kind) {
+  case ir_operand::TEMPORARY:
+    op.number = k.number = replacement[op.number];
+    break;
+  case ir_operand::VARIABLE: {
+    version_map::const_iterator p = versions.find(op.name);
+    if (p != versions.end()) k.version = p->second;
+    break;
+  }
+  default:
+    break;
+  }
+  return k;
+}
+
+
+// Also replaces the temporaries used by the instruction with the ones holding their values.
+value_key numbering::key_of(ir_instruction &i)
+{
+  value_key k;
+  k.op      = i.op;
+  k.type    = i.type;
+  k.left    = key_of(i.left);
+  k.right   = key_of(i.right);
+  k.name    = i.name;
+  k.version = 0;
+  k.detail  = i.op == IR_COMPARE ? static_cast<int>(i.relation) : i.count;
+  k.region  = cheap(i) ? region[current] : -1;
+  if (i.name != 0) {
+    version_map::const_iterator p = versions.find(i.name);
+    if (p != versions.end()) k.version = p->second;
+  }
+
+  // The order of the operands of these doesn't matter.
+  if ((i.op == IR_ADD || i.op == IR_MUL || i.op == IR_AND || i.op == IR_OR) && k.right < k.left) {
+    swap(k.left, k.right);
+  }
+  return k;
+}
+
+
+void numbering::store_into(const char *name)
+{
+  version_map::iterator p = versions.find(name);
+  version_change c = { name, p != versions.end() ? p->second : 0 };
+  changed.push_back(c);
+  versions[name] = ++last_version;
+}
+
+
+void numbering::remember(const value_key &k, int temporary)
+{
+  if (values.insert(make_pair(k, temporary)).second) added.push_back(k);
+}
+
+
+// A block reached from more than one other block gets the values of its immediate dominator.
+// Anything stored on the way from there is stored into again here. The way from the dominator
+// is found by searching back through predecessors until the dominator is reached.
+//
+void numbering::enter(int block)
+{
+  const ir_block &b = function.block(block);
+  if (b.predecessors.size() < 2) return;
+
+  vector<int> pending;
+  for (size_t p = 0; p < b.predecessors.size(); ++p) {
+    pending.push_back(b.predecessors[p]);
+  }
+  while (!pending.empty()) {
+    int x = pending.back();
+    pending.pop_back();
+    if (x == dominator[block] || visited[x] == block) continue;
+    visited[x] = block;
+
+    const ir_block &between = function.block(x);
+    for (size_t i = 0; i < between.code.size(); ++i) {
+      if (between.code[i].op == IR_STORE || between.code[i].op == IR_STORE_ELEMENT) {
+        store_into(between.code[i].name);
+      }
+    }
+    for (size_t p = 0; p < between.predecessors.size(); ++p) {
+      pending.push_back(between.predecessors[p]);
+    }
+  }
+}
+
+
+// A value stored is remembered as the value of the variable or element until the next store.
+// Only values of the same type are used in place of a load since a narrower value would be
+// widened differently by the instructions using it. The value of a variable is usually wanted
+// once after it is stored, if at all, so it is remembered only within the extended block. Any
+// further away it would be stored again and reloaded from its home, which costs as much as
+// loading the variable.
+//
+int numbering::number_block(ir_block &b)
+{
+  int removed = 0;
+  size_t kept = 0;
+  for (size_t n = 0; n < b.code.size(); ++n) {
+    ir_instruction &i = b.code[n];
+    value_key k = key_of(i);
+
+    if (i.op == IR_STORE || i.op == IR_STORE_ELEMENT) {
+      store_into(i.name);
+      ir_instruction load = i;
+      load.op    = (i.op == IR_STORE) ? IR_LOAD : IR_LOAD_ELEMENT;
+      load.right = ir_operand::none();
+      if (i.op == IR_STORE) load.left = ir_operand::none();
+      ir_operand &value = (i.op == IR_STORE) ? i.left : i.right;
+      if (value.kind == ir_operand::TEMPORARY && value.type == i.type &&
+          (i.op == IR_STORE_ELEMENT || i.type == tLONG)) {
+        value_key stored = key_of(load);
+        if (i.op == IR_STORE) stored.region = region[current];
+        remember(stored, value.number);
+      }
+    }
+    else {
+      value_table::const_iterator p = values.find(k);
+      if (p == values.end() && i.op == IR_LOAD) {
+        k.region = region[current];
+        p = values.find(k);
+        k.region = -1;
+      }
+      if (p != values.end()) {
+        replacement[i.result] = p->second;
+        ++removed;
+        continue;
+      }
+      remember(k, i.result);
+    }
+    b.code[kept++] = i;
+  }
+  b.code.resize(kept);
+
+  key_of(b.left);
+  key_of(b.right);
+  return removed;
+}
+
+
+int numbering::run()
+{
+  find_dominators();
+  find_regions();
+
+  struct frame {
+    int    block;
+    size_t values_mark;
+    size_t versions_mark;
+    bool   leaving;
+  };
+  int removed = 0;
+  frame root = { 0, 0, 0, false };
+  vector<frame> pending(1, root);
+  while (!pending.empty()) {
+    frame f = pending.back();
+    pending.pop_back();
+
+    if (f.leaving) {
+      while (added.size() > f.values_mark) {
+        values.erase(added.back());
+        added.pop_back();
+      }
+      while (changed.size() > f.versions_mark) {
+        versions[changed.back().name] = changed.back().old_version;
+        changed.pop_back();
+      }
+      continue;
+    }
+
+    f.values_mark   = added.size();
+    f.versions_mark = changed.size();
+    f.leaving       = true;
+    pending.push_back(f);
+
+    current = f.block;
+    enter(f.block);
+    removed += number_block(function.block(f.block));
+    for (int c = first_child[f.block]; c >= 0; c = next_sibling[c]) {
+      frame child = { c, 0, 0, false };
+      pending.push_back(child);
+    }
+  }
+  return removed;
+}
+
+
+int number_values(ir_function &function)
+{
+  numbering walk(function);
+  return walk.run();
+}
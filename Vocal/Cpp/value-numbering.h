@@ -0,0 +1,39 @@
+/****************************************************************************
+FILE      : value-numbering.h
+SUBJECT   : Declaration of the value numbering optimization.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Value numbering finds the instructions of the intermediate code that
+compute a value the function already has and removes them. The uses of
+their temporaries are changed to use the temporary holding the earlier
+value instead. Within a block every instruction before another one is
+considered (local value numbering). Across blocks the values computed in
+the blocks that dominate a block are considered (global value numbering)
+so a value can be reused wherever it is certain to have been computed.
+
+Loads are values too. A long variable or an array element that is loaded
+again is taken from the earlier load, or from the value last stored
+there. Storing into a variable or into any element of an array makes the
+values that depend on it different from then on. At the top of a block
+that can be reached in more than one way, the variables and arrays
+stored on any of the ways there are treated the same way.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef VALUE_NUMBERING_H
+#define VALUE_NUMBERING_H
+
+#include "intermediate-code.h"
+
+// Removes the instructions that recompute a value from a function and returns the number that
+// were removed. The function's predecessors must have been recorded by finish().
+//
+int number_values(ir_function &function);
+
+#endif
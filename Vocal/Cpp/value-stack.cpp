@@ -0,0 +1,128 @@
+/****************************************************************************
+FILE      : value-stack.cpp
+SUBJECT   : Implementation of the register allocator for expressions.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#include "instruction-list.h"
+#include "value-stack.h"
+#include <iostream>
+#include <stdlib.h>
+
+value_stack::value_stack()
+{
+  for (int i = 0; i < register_count; ++i) {
+    busy[i] = false;
+  }
+}
+
+
+// Finds a free register. If there isn't one and spilling is allowed, the oldest live entry in a
+// register that isn't held is pushed onto the machine stack. All such entries older than that
+// one are already on the machine stack, so the spilled entries are always the oldest ones, in
+// order.
+//
+int value_stack::allocate_register(bool may_spill)
+{
+  for (int i = 0; i < register_count; ++i) {
+    if (!busy[i]) {
+      busy[i] = true;
+      return i;
+    }
+  }
+
+  if (may_spill) {
+    for (std::vector<entry>::size_type i = 0; i < entries.size(); ++i) {
+      if (entries[i].live && !entries[i].held && entries[i].reg >= 0) {
+        int number = entries[i].reg;
+        code->emit(PUSH, reg(number));
+        entries[i].reg = -1;
+        return number;
+      }
+    }
+  }
+
+  // This can't happen. Reloading only occurs when an expression uses its operands, and then
+  // only those operands (a few words) are in registers.
+  //
+  std::cerr << "INTERNAL ERROR: out of registers" << std::endl;
+  exit(1);
+}
+
+
+int value_stack::push()
+{
+  entry new_entry;
+  new_entry.reg  = allocate_register(true);
+  new_entry.live = true;
+  new_entry.held = false;
+  entries.push_back(new_entry);
+  return static_cast<int>(entries.size()) - 1;
+}
+
+
+int value_stack::load(int index)
+{
+  if (entries[index].reg >= 0) return entries[index].reg;
+
+  // The spilled entries above this one are on the machine stack above it. They are popped
+  // first. Since nothing newer is in a register (except the operands of the expression using
+  // this entry and the held entries) there are free registers for them.
+  //
+  for (int i = static_cast<int>(entries.size()) - 1; i >= index; --i) {
+    if (entries[i].live && entries[i].reg < 0) {
+      entries[i].reg = allocate_register(false);
+      code->emit(POP, reg(entries[i].reg));
+    }
+  }
+  return entries[index].reg;
+}
+
+
+int value_stack::register_of(int index) const
+{
+  return entries[index].reg;
+}
+
+
+void value_stack::release(int index)
+{
+  // An entry that was never used might still be on the machine stack. Popping it is the
+  // simplest way to keep the machine stack in step with the entries.
+  load(index);
+
+  busy[entries[index].reg] = false;
+  entries[index].reg  = -1;
+  entries[index].live = false;
+  entries[index].held = false;
+  while (!entries.empty() && !entries.back().live) {
+    entries.pop_back();
+  }
+}
+
+
+void value_stack::hold(int index)
+{
+  entries[index].held = true;
+}
+
+
+int value_stack::take(int index)
+{
+  entry new_entry;
+  new_entry.reg  = entries[index].reg;
+  new_entry.live = true;
+  new_entry.held = false;
+  entries[index].reg  = -1;
+  entries[index].live = false;
+  entries[index].held = false;
+  entries.push_back(new_entry);
+  return static_cast<int>(entries.size()) - 1;
+}
@@ -0,0 +1,80 @@
+/****************************************************************************
+FILE      : value-stack.h
+SUBJECT   : Declaration of the register allocator for expressions.
+PROGRAMMER: (C) Copyright 2026 by Peter Chapin
+
+Expressions are evaluated as if on a stack. Each word of an intermediate
+value is an entry on a value_stack and the entries are kept in registers
+r0 through r6 (r7 is the stack pointer). When a new entry is needed and
+no register is free, the oldest entry still in a register is pushed onto
+the machine stack. Because expressions use their intermediate values in
+last in, first out order, spilled entries are always reloaded with pop in
+the reverse of the order in which they were pushed.
+
+A value that is used more than once (see value-numbering.h) is held in
+its register instead. Held entries are never spilled, so they can be
+used any number of times and in any order while the entries around them
+come and go. Taking the hold off an entry moves it to the top of the
+stack so that the entries that aren't held are still used in last in,
+first out order.
+
+Please send comments or bug reports to
+
+     Peter Chapin
+     Vermont Technical College
+     Williston, VT 05495
+     PChapin@vtc.vsc.edu
+****************************************************************************/
+
+#ifndef VALUE_STACK_H
+#define VALUE_STACK_H
+
+#include <vector>
+
+class value_stack {
+public:
+  // Registers r0 .. r6 are available for values.
+  static const int register_count = 7;
+
+  value_stack();
+
+  // Creates a new entry on top of the stack and gives it a register, spilling the oldest entry
+  // in a register if necessary. Returns the index of the new entry.
+  int push();
+
+  // Makes sure an entry is in a register, reloading it from the machine stack if it was
+  // spilled. Returns the register number.
+  int load(int index);
+
+  // Returns the register holding an entry. The entry must be in a register.
+  int register_of(int index) const;
+
+  // Discards an entry. Its register becomes available again.
+  void release(int index);
+
+  // Keeps an entry in its register until it is released or taken. The entry must be in a
+  // register.
+  void hold(int index);
+
+  // Ends the hold on an entry. Its register is given to a new entry on top of the stack, as if
+  // the value had just been computed, and the index of that entry is returned.
+  //
+  int take(int index);
+
+  // Returns true if there are no entries.
+  bool empty() const { return entries.empty(); }
+
+private:
+  struct entry {
+    int  reg;     // -1 when the entry is on the machine stack.
+    bool live;
+    bool held;    // Never spilled.
+  };
+
+  std::vector<entry> entries;   // Oldest first.
+  bool busy[register_count];
+
+  int allocate_register(bool may_spill);
+};
+
+#endif